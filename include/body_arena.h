@@ -0,0 +1,41 @@
+#ifndef BODY_ARENA_H
+#define BODY_ARENA_H
+
+#include <Arduino.h>
+
+// Fester Puffer für einen Request-Body
+struct BodyArena {
+    uint8_t* data;
+    size_t capacity;
+    size_t length;        // Erwartete Länge (Content-Length)
+    size_t received;
+    bool inUse;
+};
+
+// Kleiner Pool gleich großer Arenen, einmalig beim Start angelegt (bevorzugt
+// PSRAM). Requests leihen sich eine Arena für die Dauer der Verarbeitung,
+// dadurch entsteht pro Request keine Heap-Allokation und keine Fragmentierung.
+class BodyArenaPool {
+public:
+    BodyArenaPool();
+    ~BodyArenaPool();
+
+    bool begin(size_t count, size_t size);
+
+    // Liefert eine freie Arena oder nullptr, wenn alle belegt sind
+    BodyArena* acquire();
+    void release(BodyArena* arena);
+
+    size_t getArenaSize() const { return arenaSize; }
+    uint32_t getExhaustedCount() const { return exhausted; }
+
+private:
+    BodyArena* arenas;
+    size_t arenaCount;
+    size_t arenaSize;
+    uint8_t* memory;
+    uint32_t exhausted;
+    portMUX_TYPE lock;
+};
+
+#endif
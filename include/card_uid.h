@@ -0,0 +1,111 @@
+#ifndef CARD_UID_H
+#define CARD_UID_H
+
+#include <Arduino.h>
+#include <array>
+
+// Binäre RFID UID (4, 7 oder 10 Bytes) als Wert-Typ ohne Heap-Allokation.
+// Wird vom RFID-Task bis zum Hash-Index im StorageManager durchgereicht;
+// der Hash wird beim Erzeugen einmal berechnet. In Text (Hex) wird die UID
+// erst an den Schnittstellen (REST API, Log) umgewandelt.
+struct CardUid {
+    static const uint8_t MAX_LENGTH = 10;
+    // Puffergröße für toHex() inklusive Nullterminator
+    static const size_t HEX_SIZE = MAX_LENGTH * 2 + 1;
+
+    uint8_t length;
+    std::array<uint8_t, MAX_LENGTH> bytes;
+
+    CardUid() : length(0), bytes{}, hashValue(EMPTY_HASH) {}
+
+    static CardUid fromBytes(const uint8_t* data, uint8_t size) {
+        CardUid uid;
+        uid.length = (size > MAX_LENGTH) ? MAX_LENGTH : size;
+        for (uint8_t i = 0; i < uid.length; i++) {
+            uid.bytes[i] = data[i];
+        }
+        uid.updateHash();
+        return uid;
+    }
+
+    // Parst einen Hex-String ("A1B2C3D4", Groß-/Kleinschreibung egal) ohne Allokation
+    static bool fromHex(const char* hex, size_t len, CardUid& out) {
+        if (len == 0 || (len & 1) || len / 2 > MAX_LENGTH) {
+            return false;
+        }
+        CardUid uid;
+        uid.length = len / 2;
+        for (uint8_t i = 0; i < uid.length; i++) {
+            int hi = hexValue(hex[i * 2]);
+            int lo = hexValue(hex[i * 2 + 1]);
+            if (hi < 0 || lo < 0) {
+                return false;
+            }
+            uid.bytes[i] = (hi << 4) | lo;
+        }
+        uid.updateHash();
+        out = uid;
+        return true;
+    }
+
+    static bool fromHex(const String& hex, CardUid& out) {
+        return fromHex(hex.c_str(), hex.length(), out);
+    }
+
+    bool isEmpty() const { return length == 0; }
+
+    // FNV-1a über Länge und Bytes (vorberechnet)
+    uint32_t hash() const { return hashValue; }
+
+    // Schreibt die UID als Hex ("A1B2C3D4") nach out (mind. HEX_SIZE Bytes)
+    size_t toHex(char* out) const {
+        for (uint8_t i = 0; i < length; i++) {
+            out[i * 2] = hexDigit(bytes[i] >> 4);
+            out[i * 2 + 1] = hexDigit(bytes[i]);
+        }
+        out[length * 2] = '\0';
+        return length * 2;
+    }
+
+    static constexpr char hexDigit(uint8_t nibble) {
+        return "0123456789ABCDEF"[nibble & 0x0F];
+    }
+
+    bool operator==(const CardUid& other) const {
+        if (length != other.length || hashValue != other.hashValue) {
+            return false;
+        }
+        for (uint8_t i = 0; i < length; i++) {
+            if (bytes[i] != other.bytes[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool operator!=(const CardUid& other) const { return !(*this == other); }
+
+private:
+    // FNV-1a über die Länge 0
+    static const uint32_t EMPTY_HASH = (2166136261u ^ 0u) * 16777619u;
+
+    uint32_t hashValue;
+
+    void updateHash() {
+        uint32_t h = 2166136261u;
+        h = (h ^ length) * 16777619u;
+        for (uint8_t i = 0; i < length; i++) {
+            h = (h ^ bytes[i]) * 16777619u;
+        }
+        hashValue = h;
+    }
+
+    static int hexValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return -1;
+    }
+};
+
+#endif
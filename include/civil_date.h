@@ -0,0 +1,139 @@
+#ifndef CIVIL_DATE_H
+#define CIVIL_DATE_H
+
+#include <Arduino.h>
+#include <time.h>
+
+// Kalenderrechnung auf Basis fortlaufender Tagesnummern ("Epoch-Tage", Tage
+// seit 1970-01-01) im proleptischen Gregorianischen Kalender. Unabhängig von
+// Zeitzone und Sommerzeit - Differenzen zwischen Daten sind damit einfache
+// Subtraktionen. Algorithmen nach H. Hinnant ("chrono-Compatible Low-Level
+// Date Algorithms"), als C++11-constexpr in einzelne Ausdrücke zerlegt.
+
+// Markierung für ein ungültiges/fehlendes Datum
+static const int32_t INVALID_EPOCH_DAY = INT32_MIN;
+
+// Letzter Epoch-Tag, dessen Zeitpunkte noch in time_t passen. Mit 32-Bit
+// time_t (arduino-esp32 2.x) ist das der 2038-01-18 - einen Tag Abstand für
+// Zeitzonen-Offsets. Die Tagesrechnung selbst ist davon nicht betroffen.
+static const int32_t TIME_T_MAX_EPOCH_DAY = sizeof(time_t) > 4 ? INT32_MAX - 1 : INT32_MAX / 86400 - 1;
+
+struct CivilDate {
+    int32_t year;
+    uint8_t month;      // 1-12
+    uint8_t day;        // 1-31
+
+    constexpr CivilDate(int32_t y, uint8_t m, uint8_t d) : year(y), month(m), day(d) {}
+};
+
+constexpr bool isLeapYear(int32_t year) {
+    return (year % 4 == 0) && (year % 100 != 0 || year % 400 == 0);
+}
+
+constexpr uint8_t daysInMonth(int32_t year, uint8_t month) {
+    return month == 2 ? (isLeapYear(year) ? 29 : 28)
+                      : ((month == 4 || month == 6 || month == 9 || month == 11) ? 30 : 31);
+}
+
+// Hilfsfunktionen: Jahre beginnen intern am 1. März (Schalttag am Jahresende),
+// eine "Ära" umfasst 400 Jahre = 146097 Tage
+constexpr int32_t civilEra(int32_t year) {
+    return (year >= 0 ? year : year - 399) / 400;
+}
+
+constexpr uint32_t civilDayOfYear(uint32_t month, uint32_t day) {
+    return (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+}
+
+constexpr uint32_t civilDayOfEra(uint32_t yearOfEra, uint32_t dayOfYear) {
+    return yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+}
+
+constexpr int32_t civilShiftedToDays(int32_t year, uint32_t month, uint32_t day) {
+    return civilEra(year) * 146097 +
+           (int32_t)civilDayOfEra((uint32_t)(year - civilEra(year) * 400), civilDayOfYear(month, day)) - 719468;
+}
+
+// Datum -> Epoch-Tag (1970-01-01 = 0)
+constexpr int32_t daysFromCivil(int32_t year, uint8_t month, uint8_t day) {
+    return civilShiftedToDays(month <= 2 ? year - 1 : year, month, day);
+}
+
+constexpr CivilDate civilFromMonthIndex(int32_t year, uint32_t dayOfYear, uint32_t monthIndex) {
+    return CivilDate(year + (monthIndex >= 10 ? 1 : 0),
+                     (uint8_t)(monthIndex < 10 ? monthIndex + 3 : monthIndex - 9),
+                     (uint8_t)(dayOfYear - (153 * monthIndex + 2) / 5 + 1));
+}
+
+constexpr CivilDate civilFromDayOfYear(int32_t year, uint32_t dayOfYear) {
+    return civilFromMonthIndex(year, dayOfYear, (5 * dayOfYear + 2) / 153);
+}
+
+constexpr CivilDate civilFromYearOfEra(int32_t era, uint32_t dayOfEra, uint32_t yearOfEra) {
+    return civilFromDayOfYear((int32_t)yearOfEra + era * 400,
+                              dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100));
+}
+
+constexpr CivilDate civilFromDayOfEra(int32_t era, uint32_t dayOfEra) {
+    return civilFromYearOfEra(era, dayOfEra,
+                              (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365);
+}
+
+constexpr int32_t civilDaysEra(int32_t shifted) {
+    return (shifted >= 0 ? shifted : shifted - 146096) / 146097;
+}
+
+constexpr CivilDate civilFromShifted(int32_t shifted) {
+    return civilFromDayOfEra(civilDaysEra(shifted), (uint32_t)(shifted - civilDaysEra(shifted) * 146097));
+}
+
+// Epoch-Tag -> Datum
+constexpr CivilDate civilFromDays(int32_t days) {
+    return civilFromShifted(days + 719468);
+}
+
+// Wochentag eines Epoch-Tags (0 = Sonntag ... 6 = Samstag, wie tm_wday)
+constexpr uint8_t weekdayFromDays(int32_t days) {
+    return (uint8_t)(days >= -4 ? (days + 4) % 7 : (days + 5) % 7 + 6);
+}
+
+static_assert(daysFromCivil(1970, 1, 1) == 0, "Epoche");
+static_assert(daysFromCivil(2000, 3, 1) == 11017, "Schaltjahr 2000");
+static_assert(civilFromDays(11016).day == 29, "29.02.2000");
+static_assert(weekdayFromDays(0) == 4, "1970-01-01 war ein Donnerstag");
+
+// Parst "YYYY-MM-DD" streng (feste Länge, gültiger Tag im Monat).
+// Liefert INVALID_EPOCH_DAY bei ungültiger Eingabe.
+int32_t parseIsoDate(const char* text, size_t len);
+inline int32_t parseIsoDate(const String& text) {
+    return parseIsoDate(text.c_str(), text.length());
+}
+
+// Heutiger Epoch-Tag in lokaler Zeit. localtime()/mktime() laufen nur beim
+// Wechsel des lokalen Tages (oder wenn die Uhr springt), sonst ist der Aufruf
+// ein Vergleich mit den Grenzen des zwischengespeicherten Tages.
+int32_t localEpochDay(time_t now);
+inline int32_t localEpochDay() {
+    return localEpochDay(time(nullptr));
+}
+// Nach einer Zeitzonenänderung: zwischengespeicherten Tag verwerfen
+void invalidateLocalDay();
+
+// Parst eine Uhrzeit "HH:MM" (00:00-23:59) streng. Liefert die Minute des
+// Tages oder NO_TIME_OF_DAY bei ungültiger Eingabe.
+static const int16_t NO_TIME_OF_DAY = -1;
+int16_t parseTimeOfDay(const char* text, size_t len);
+inline int16_t parseTimeOfDay(const String& text) {
+    return parseTimeOfDay(text.c_str(), text.length());
+}
+
+// Zeitpunkt, zu dem die lokale Uhr am Epoch-Tag die angegebene Minute des
+// Tages zeigt (über mktime(), d.h. mit der eingestellten Zeitzone).
+// 0 nach TIME_T_MAX_EPOCH_DAY (nicht als time_t darstellbar)
+time_t localTimeOf(int32_t epochDay, int minuteOfDay);
+
+// Nächster Zeitpunkt (nach `now`), zu dem die lokale Uhr hour:minute zeigt.
+// Über mktime() berechnet, also korrekt an Tagen der Sommerzeit-Umstellung.
+time_t nextLocalTime(time_t now, int hour, int minute);
+
+#endif
@@ -7,6 +7,18 @@
 #define RFID_SCK_PIN    18
 #define RFID_MOSI_PIN   23
 #define RFID_MISO_PIN   19
+#define RFID_IRQ_PIN    -1    // IRQ des RC522 (optional, -1 = nur Polling)
+
+// RFID-Task: liest den RC522 unabhängig von loop() und dem Display
+#define RFID_TASK_CORE          0
+#define RFID_TASK_PRIORITY      2       // Über Storage/Display, unter WiFi
+#define RFID_TASK_STACK         3072
+#define RFID_POLL_INTERVAL_MS   50      // Abfrageintervall (im IRQ-Modus: REQA-Intervall)
+#define RFID_ARRIVE_DEBOUNCE_MS 0       // So lange muss eine Karte durchgehend antworten (0 = sofort)
+#define RFID_REMOVE_DEBOUNCE_MS 250     // So lange ohne Antwort bis "Karte entfernt"
+#define RFID_RX_TIMEOUT_US      2000    // Antwort-Timeout des RC522 (Bibliothek: 25 ms)
+// GET /api/scan-card?wait=<ms>: maximale Wartezeit auf die nächste Karte
+#define SCAN_CARD_MAX_WAIT_MS   15000
 
 // E-Ink Display Pins (Waveshare E-Paper ESP32 Driver Board)
 // Diese Pins sind fest auf dem Board verdrahtet!
@@ -21,10 +33,90 @@
 #define WIFI_SSID       "CountdownDisplay"
 #define WIFI_PASSWORD   "countdown123"
 
+// Verbindungsaufbau im Hintergrund (setup() wartet nicht auf WiFi)
+#define WIFI_FAST_CONNECT_TIMEOUT_MS  3000    // Versuch mit gecachter BSSID/Kanal
+#define WIFI_CONNECT_TIMEOUT_MS       10000   // Danach: Access Point als Fallback
+#define WIFI_CACHE_NAMESPACE          "wifi"  // NVS-Namespace für BSSID/Kanal
+
+// Zeit: POSIX-TZ (im Webinterface änderbar), SNTP mit Backoff
+#define TIME_ZONE_DEFAULT             "CET-1CEST,M3.5.0,M10.5.0/3"
+#define TIME_ZONE_MAX_LENGTH          64
+#define NTP_SERVER_1                  "pool.ntp.org"
+#define NTP_SERVER_2                  "time.nist.gov"
+#define TIME_SYNC_INTERVAL_S          21600   // Reguläre SNTP-Synchronisation (6 h)
+#define TIME_SYNC_RETRY_MIN_S         30      // Backoff ohne Synchronisation: 30 s ...
+#define TIME_SYNC_RETRY_MAX_S         3600    // ... verdoppelt bis 1 h
+#define TIME_SAVE_INTERVAL_S          21600   // Letzte gute Zeit im NVS sichern
+#define TIME_DRIFT_MIN_INTERVAL_S     3600    // Kürzere Abstände ergeben keine Drift-Messung
+#define TIME_DRIFT_MAX_PPM            200     // Größere Werte gelten als Messfehler
+#define TIME_NVS_NAMESPACE            "time"
+
 // Maximum number of countdowns
-#define MAX_COUNTDOWNS  20
+#define MAX_COUNTDOWNS  256
+// Maximale Feldlängen (Bytes): ein Countdown muss als Record ins Journal und
+// selbst mit lauter \uXXXX-Escapes als ein Element in den JSON-Stream passen
+#define COUNTDOWN_NAME_MAX_LENGTH   64
+#define COUNTDOWN_PATH_MAX_LENGTH   64
+
+// Partial Refresh (z.B. Mitternachts-Update der Tageszahl)
+// Nach so vielen Partial Refreshes wird ein vollständiger Refresh eingeplant (gegen Ghosting)
+#define PARTIAL_REFRESH_LIMIT   7
+// Stunde (0-23), in der ein eingeplanter Full Refresh nachts ausgeführt wird
+// -1 = Full Refresh sofort beim nächsten Update statt im Nacht-Slot
+#define FULL_REFRESH_HOUR       3
+// Ghosting-Schutz: höchstens so viele Full Refreshes pro Tag (Nacht-Slot
+// eingeschlossen); danach wird bis zum nächsten Tag nur noch partiell aktualisiert
+#define FULL_REFRESH_DAILY_BUDGET   3
+
+// Stunden-Countdown: Countdowns mit Uhrzeit zeigen in den letzten 24 Stunden
+// HH:MM statt der Tageszahl. Aktualisiert wird nur dieses Rechteck, alle
+// CLOCK_UPDATE_MINUTES Minuten (1, 5 oder 15)
+#define CLOCK_UPDATE_MINUTES        5
+// Partial Refreshes der (kleinen) Uhrzeit-Fläche, bis ein Full Refresh eingeplant wird
+#define CLOCK_PARTIAL_REFRESH_LIMIT 96
+
+// Display Render-Pipeline (Panel-Task für Übertragung + Refresh)
+#define DISPLAY_TASK_CORE       1
+#define DISPLAY_TASK_PRIORITY   1
+#define DISPLAY_TASK_STACK      4096
+
+// Bildfläche neben dem Countdown (Uploads werden auf diese Größe konvertiert)
+#define IMAGE_MAX_WIDTH         250
+#define IMAGE_MAX_HEIGHT        250
+// Maximale Länge des Dateinamens (ohne Endung) hochgeladener Bilder
+#define IMAGE_NAME_MAX_LENGTH   32
+
+// Blockgröße für das Lesen von Bilddateien (falls nicht komplett in PSRAM passend)
+#define BMP_READ_CHUNK          8192
+// Größere Bilder werden beim Anzeigen herunterskaliert (bis max. Kantenlänge)
+#define BMP_MAX_SOURCE_SIZE     8192
+// true = Floyd-Steinberg Dithering beim Skalieren, false = einfacher Schwellwert
+#define IMAGE_DITHER            true
+
+// REST API: Request-Bodies werden in festen Arenen gesammelt (bevorzugt PSRAM).
+// Größere Bodies werden mit 413 abgelehnt, sind alle Arenen belegt mit 503.
+#define BODY_ARENA_COUNT        4
+#define BODY_ARENA_SIZE         2048
+// Bulk-Import (NDJSON): mehr Zeilen werden mit 413 abgelehnt. Gemeldet werden
+// höchstens BULK_IMPORT_MAX_ERRORS fehlerhafte Zeilen, gezählt werden alle.
+#define BULK_IMPORT_MAX_LINES   (MAX_COUNTDOWNS * 2)
+#define BULK_IMPORT_MAX_ERRORS  32
+
+// Storage: binärer Snapshot + Journal (Append-Only, CRC-geschützt)
+#define STORE_SNAPSHOT_FILE     "/store.snap"
+#define STORE_JOURNAL_FILE      "/store.log"
+// Ab dieser Journalgröße (Bytes) wird in einen neuen Snapshot kompaktiert
+#define JOURNAL_COMPACT_SIZE    16384
+
+// Verzögertes Schreiben (Write-Behind): Änderungen werden gesammelt und von
+// einem Hintergrund-Task nach einer Ruhephase gebündelt geschrieben
+#define STORAGE_WRITE_BEHIND        true    // false: synchron im aufrufenden (auch Web-)Task
+#define STORAGE_FLUSH_QUIET_MS      2000    // Ruhephase nach der letzten Änderung
+#define STORAGE_FLUSH_MAX_DELAY_MS  10000   // Maximale Verzögerung ab der ersten Änderung
+#define STORAGE_TASK_PRIORITY       1       // Niedrig, unterhalb von Netzwerk und Display
+#define STORAGE_TASK_STACK          4096
 
-// Storage file
+// Legacy JSON-Konfiguration (Migration beim ersten Start, Import/Export)
 #define CONFIG_FILE     "/config.json"
 
 #endif
@@ -9,7 +9,10 @@
 #include <Fonts/FreeSans18pt7b.h>
 #include <Fonts/FreeSans12pt7b.h>
 #include <Fonts/FreeSans9pt7b.h>
+#include <functional>
+#include <FS.h>
 #include "storage.h"
+#include "framebuffer.h"
 
 // Externe HSPI-Bus Referenz (für Waveshare E-Paper ESP32 Driver Board)
 extern SPIClass hspi;
@@ -22,20 +25,103 @@ public:
     bool begin();
 
     void showWelcomeScreen();
-    void showCountdown(const Countdown& countdown, int daysRemaining);
+    // minutesRemaining >= 0: Stunden-Countdown (HH:MM) statt der Tageszahl
+    void showCountdown(const Countdown& countdown, int daysRemaining, int minutesRemaining = -1);
+    // Aktualisiert nur Tageszahl + Label per Partial Refresh (z.B. um Mitternacht).
+    // Fällt auf showCountdown() zurück, wenn ein anderer Countdown angezeigt wird.
+    void updateDaysRemaining(const Countdown& countdown, int daysRemaining);
+    // Stunden-Countdown: aktualisiert nur die Fläche der Uhrzeit (beim Wechsel
+    // aus der Tagesanzeige einmal den ganzen Tage-Block)
+    void updateTimeRemaining(const Countdown& countdown, int daysRemaining, int minutesRemaining);
+    // true, wenn genau dieser Countdown unverändert angezeigt wird (Partial Refresh möglich)
+    bool isShowing(const Countdown& countdown);
     void showError(const String& message);
     void showNoCardScreen();
     void clear();
 
-    int calculateDaysRemaining(const String& targetDate);
+    // Tage bis zum (nächsten) Zieldatum, lokaler Kalendertag; -9999 bei ungültigem Datum
+    int calculateDaysRemaining(const Countdown& countdown);
+    // Zeitpunkt des (nächsten) Ereignisses, 0 ohne Uhrzeit oder bei ungültigem Datum
+    time_t calculateTargetTime(const Countdown& countdown);
+    // Minuten bis zum Ereignis (aufgerundet), wenn es höchstens 24 Stunden
+    // entfernt ist; sonst -1 (Tagesanzeige)
+    int calculateMinutesRemaining(const Countdown& countdown);
+
+    // Ghosting-Schutz: Nach PARTIAL_REFRESH_LIMIT Partial Refreshes wird ein
+    // Full Refresh eingeplant und im Nacht-Slot (FULL_REFRESH_HOUR) ausgeführt
+    bool isFullRefreshPending() const { return fullRefreshPending; }
+    void performScheduledFullRefresh();
+    uint16_t getPartialRefreshCount() const { return partialRefreshCount; }
+
+    // Render-Pipeline: true solange das Panel noch ein Bild überträgt/refresht
+    bool isBusy() const;
+    void waitUntilIdle();
+    uint32_t getPanelRefreshCount() const { return panelRefreshCount; }
+    bool wasLastRefreshPartial() const { return lastRefreshPartial; }
+    uint32_t getLastRefreshDuration() const { return lastRefreshMs; }
 
 private:
+    // Seitenpuffer von GxEPD2 nur noch für den Fallback ohne Framebuffer. Volle
+    // Höhe = eine Seite: draw() (samt Bild-Dekodierung) läuft pro Bild genau
+    // einmal statt einmal pro Seite; kostet wie bisher 48 KB Heap.
     GxEPD2_BW<GxEPD2_750_T7, GxEPD2_750_T7::HEIGHT>* display;
 
+    // Zeichenziel: aktueller Framebuffer oder (Fallback) das GxEPD2 Paging
+    Adafruit_GFX* gfx;
+    FrameBuffer* canvas;      // Gesetzt, wenn gfx ein Framebuffer ist (direkter Bit-Blit)
+
+    // Double Buffering: Komposition in einen Puffer, während der andere
+    // vom Panel-Task übertragen und refresht wird
+    struct PanelJob {
+        uint8_t buffer;
+        bool partial;
+        int16_t x, y, w, h;
+    };
+    FrameBuffer* framebuffers[2];
+    SemaphoreHandle_t bufferFree[2];
+    QueueHandle_t panelQueue;
+    TaskHandle_t panelTask;
+    volatile bool panelBusy;
+    volatile uint32_t panelRefreshCount;
+    volatile bool lastRefreshPartial;
+    volatile uint32_t lastRefreshMs;
+    int8_t frontBuffer;       // Zuletzt komponierter Puffer (-1 = keiner)
+    bool pipelineReady;
+
+    // Zustand des aktuell angezeigten Countdowns (für Partial Refresh)
+    bool countdownShown;
+    bool shownWithImage;
+    int shownDays;
+    int shownMinutes;           // Stunden-Countdown, -1 = Tagesanzeige
+    int32_t shownDate;          // Angezeigtes (nächstes) Datum als Epoch-Tag
+    Countdown shownCountdown;
+    uint16_t partialRefreshCount;
+    uint16_t clockRefreshCount; // Partial Refreshes nur der Uhrzeit-Fläche
+    bool fullRefreshPending;
+    int32_t budgetDay;          // Lokaler Tag des Full-Refresh-Budgets
+    uint8_t budgetUsed;
+
     void drawCenteredText(const String& text, int y, const GFXfont* font);
     void drawBorder();
-    String formatDateGerman(const String& date);
-    bool drawBMPImage(const String& filename, int16_t x, int16_t y, int16_t maxWidth, int16_t maxHeight);
+    void drawDaysBlock(int daysRemaining, int minutesRemaining, bool hasImage);
+    void getDaysBlockRegion(bool hasImage, int16_t& x, int16_t& y, int16_t& w, int16_t& h);
+    void getClockRegion(bool hasImage, int16_t& x, int16_t& y, int16_t& w, int16_t& h);
+    String daysLabel(int daysRemaining);
+    bool takeFullRefreshBudget();
+    void resetRefreshState(bool showingCountdown);
+
+    // Komponiert einen Screen (draw) und übergibt ihn ans Panel.
+    // partial: nur das Rechteck x/y/w/h wird übertragen und refresht
+    void present(const std::function<void()>& draw, bool partial = false,
+                 int16_t x = 0, int16_t y = 0, int16_t w = 0, int16_t h = 0);
+    static void panelTaskEntry(void* param);
+    void panelLoop();
+    String formatDateGerman(int32_t epochDay);
+    int32_t occurrenceDay(const Countdown& countdown);
+    void blitPackedRow(int16_t x, int16_t y, const uint8_t* bits, int16_t w, bool invert);
+    bool drawImage(const String& filename, int16_t x, int16_t y, int16_t maxWidth, int16_t maxHeight);
+    bool drawNativeImage(File& file, int16_t x, int16_t y, int16_t maxWidth, int16_t maxHeight);
+    bool drawBMPImage(File& file, int16_t x, int16_t y, int16_t maxWidth, int16_t maxHeight);
 };
 
 extern DisplayManager displayManager;
@@ -0,0 +1,44 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+
+// 1bpp Off-Screen Framebuffer (800x480 = 48 KB), bevorzugt im PSRAM.
+// Bit-Polarität wie GxEPD2: 1 = weiß, 0 = schwarz, MSB = linkes Pixel.
+// Dadurch kann der Puffer unverändert per epd2.writeImage() gesendet werden.
+class FrameBuffer : public Adafruit_GFX {
+public:
+    FrameBuffer(int16_t width, int16_t height);
+    ~FrameBuffer();
+
+    // Reserviert den Puffer (PSRAM, sonst interner RAM)
+    bool begin();
+    bool isAllocated() const { return buffer != nullptr; }
+    bool isInPSRAM() const { return inPSRAM; }
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+    void fillScreen(uint16_t color) override;
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+
+    // Schreibt eine Zeile gepackter 1bpp Pixel (MSB zuerst, 1 = weiß) ab (x, y).
+    // Byte-ausgerichtete Ziele werden per memcpy kopiert, sonst per Bit-Shift.
+    // invert: Quellbits vor dem Schreiben invertieren (BMP Paletten-Polarität)
+    void drawRowBits(int16_t x, int16_t y, const uint8_t* src, int16_t w, bool invert);
+
+    // Kopiert den kompletten Inhalt eines gleich großen Framebuffers
+    void copyFrom(const FrameBuffer& other);
+
+    uint8_t* getBuffer() const { return buffer; }
+    uint16_t getStride() const { return stride; }
+    size_t getSize() const { return (size_t)stride * HEIGHT; }
+
+private:
+    uint8_t* buffer;
+    uint16_t stride;   // Bytes pro Zeile
+    bool inPSRAM;
+};
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef IMAGE_SCALER_H
+#define IMAGE_SCALER_H
+
+#include <Arduino.h>
+
+// Streaming Flächenmittelungs-Downscaler (Area Averaging) in Festkomma.
+// Quellzeilen werden genau einmal in Leserichtung übergeben; Speicherbedarf
+// ist nur O(Zielbreite) (drei Zeilenpuffer), unabhängig von der Quellgröße.
+// Nur Verkleinerung: dstW <= srcW und dstH <= srcH.
+//
+// Gewichte sind exakt: Quellpixel x überdeckt [x*dstW, (x+1)*dstW), Zielpixel t
+// überdeckt [t*srcW, (t+1)*srcW) (analog vertikal) - alles ganzzahlig.
+class AreaDownscaler {
+public:
+    AreaDownscaler();
+    ~AreaDownscaler();
+
+    bool begin(uint16_t srcWidth, uint16_t srcHeight, uint16_t dstWidth, uint16_t dstHeight);
+    void end();
+
+    // Übergibt die nächste Quellzeile. Rückgabe true: eine Zielzeile ist fertig
+    // und kann über outputRow()/outputRowIndex() abgeholt werden (bis zum nächsten Aufruf).
+    bool pushRowGray(const uint8_t* gray);                     // 0 = schwarz .. 255 = weiß
+    bool pushRow1bpp(const uint8_t* bits, bool invert);        // MSB zuerst, 1 = weiß (ohne invert)
+
+    const uint8_t* outputRow() const { return outRow; }
+    uint16_t outputRowIndex() const { return outIndex; }
+    uint16_t getDstWidth() const { return dstW; }
+    uint16_t getDstHeight() const { return dstH; }
+
+    // Größte Zielgröße innerhalb maxW x maxH mit gleichem Seitenverhältnis
+    static void fitInto(uint16_t srcWidth, uint16_t srcHeight, uint16_t maxWidth, uint16_t maxHeight,
+                        uint16_t& dstWidth, uint16_t& dstHeight);
+
+private:
+    uint16_t srcW, srcH, dstW, dstH;
+    uint16_t srcRow;          // Index der nächsten Quellzeile
+    uint16_t curRow;          // Aktuell akkumulierte Zielzeile
+    uint16_t outIndex;        // Index der zuletzt ausgegebenen Zielzeile
+    uint32_t* rowSum;         // Horizontale Summe der aktuellen Quellzeile
+    uint32_t* accum;          // Vertikal gewichtete Summe der Zielzeile
+    uint8_t* outRow;          // Fertige Zielzeile (Graustufen)
+
+    template <typename PixelFn>
+    bool pushRow(PixelFn pixel);
+};
+
+// Floyd-Steinberg Dithering von Graustufen-Zeilen auf gepackte 1bpp Zeilen
+// (MSB zuerst, 1 = weiß). Fehler wird in einem rollierenden Puffer aus zwei
+// Zeilen verteilt - Speicherbedarf O(Breite).
+class FloydSteinbergDither {
+public:
+    FloydSteinbergDither();
+    ~FloydSteinbergDither();
+
+    bool begin(uint16_t width, bool dither = true);
+    void end();
+
+    // gray: width Bytes, packed: (width + 7) / 8 Bytes
+    void processRow(const uint8_t* gray, uint8_t* packed);
+
+private:
+    uint16_t width;
+    bool enabled;             // false = einfacher Schwellwert
+    int16_t* errCur;
+    int16_t* errNext;
+};
+
+#endif
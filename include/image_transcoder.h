@@ -0,0 +1,98 @@
+#ifndef IMAGE_TRANSCODER_H
+#define IMAGE_TRANSCODER_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "image_scaler.h"
+
+// Display-natives Bildformat (".cdi"): 16 Byte Header, danach top-down,
+// byte-ausgerichtete 1bpp Zeilen (MSB zuerst, 1 = weiß) - kann direkt in den
+// Framebuffer kopiert werden.
+//
+//   0  'C' 'D' 'I' '1'
+//   4  uint16 width, uint16 height, uint16 stride (Bytes pro Zeile)
+//  10  6 Bytes reserviert (0)
+#define CDI_MAGIC           "CDI1"
+#define CDI_HEADER_SIZE     16
+#define CDI_EXTENSION       ".cdi"
+
+struct CdiHeader {
+    uint16_t width;
+    uint16_t height;
+    uint16_t stride;
+};
+
+bool readCdiHeader(File& file, CdiHeader& header);
+
+// Wandelt hochgeladene Bilder während des Empfangs Chunk für Chunk in das
+// native Format um. Unterstützt unkomprimierte BMPs mit 1/8/24/32 Bit und
+// Graustufen-PGM (P5). Große Bilder werden dabei auf maxWidth x maxHeight
+// herunterskaliert und per Floyd-Steinberg auf 1bpp gedithert.
+class ImageTranscoder {
+public:
+    ImageTranscoder();
+    ~ImageTranscoder();
+
+    // outputPath: Zieldatei (wird erst bei finish() erfolgreich angelegt)
+    bool begin(const String& outputPath, uint16_t maxWidth, uint16_t maxHeight);
+    bool write(const uint8_t* data, size_t len);
+    bool finish();
+    void abort();
+
+    bool isActive() const { return state != State::Idle; }
+    const String& getError() const { return error; }
+    uint16_t getOutputWidth() const { return outW; }
+    uint16_t getOutputHeight() const { return outH; }
+
+private:
+    enum class State { Idle, Header, Skip, Rows, Done, Failed };
+    enum class Format { Unknown, Bmp, Pgm };
+
+    State state;
+    Format format;
+    String error;
+    String path;
+    String tempPath;
+
+    uint16_t maxW, maxH;
+
+    // Header-Puffer (BMP inkl. Palette bis 1078 Bytes, PGM Textheader)
+    uint8_t* header;
+    size_t headerLen;
+    size_t headerNeed;
+
+    // Quellbild
+    uint32_t srcW, srcH;
+    uint16_t bpp;
+    bool topDown;
+    uint32_t pixelOffset;     // BMP: Offset des Pixel-Arrays
+    uint32_t bytePos;         // Bisher verarbeitete Eingabebytes
+    uint32_t srcRowSize;
+    uint32_t srcRowsDone;
+    uint16_t pgmMaxVal;
+    uint8_t paletteLuma[256];
+
+    // Zeilenpuffer
+    uint8_t* rowBuf;
+    size_t rowFill;
+    uint8_t* grayRow;
+
+    // Ausgabe: komplette .cdi-Datei (Header + Zeilen), wird in finish() in
+    // einem Stück geschrieben. Bei IMAGE_MAX_WIDTH x IMAGE_MAX_HEIGHT ~8 KB.
+    uint8_t* image;
+    uint16_t outW, outH, outStride;
+    bool scaling;
+    AreaDownscaler scaler;
+    FloydSteinbergDither dither;
+
+    bool fail(const String& message);
+    bool parseHeader();
+    bool parseBmpHeader();
+    bool parsePgmHeader();
+    bool startOutput();
+    bool processRow();
+    bool emitRow(const uint8_t* gray, uint16_t sourceOrderIndex);
+    void releaseBuffers();
+};
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <vector>
+
+// Binäres Record-Format für Snapshot und Journal des StorageManagers.
+//
+// Datei:  'C' 'D' 'J' '1'  gefolgt von Records
+// Record: uint8 type, uint16 length (LE), uint32 crc32 (LE), payload[length]
+//         Die CRC deckt type, length und payload ab.
+//
+// Snapshot und Journal haben dasselbe Format; der Snapshot enthält nur den
+// kompakten Zustand, das Journal die seitdem angehängten Änderungen.
+#define JOURNAL_MAGIC           "CDJ1"
+#define JOURNAL_MAGIC_SIZE      4
+#define JOURNAL_RECORD_HEADER   7
+#define JOURNAL_MAX_PAYLOAD     1024
+
+enum class RecordType : uint8_t {
+    Put = 1,        // Countdown angelegt/geändert (kompletter Datensatz)
+    Delete = 2,     // Countdown gelöscht (UID)
+    WiFi = 3        // WLAN-Zugangsdaten
+};
+
+// Baut den Payload eines Records zusammen (Strings mit uint16 Längenpräfix)
+class RecordBuilder {
+public:
+    void clear() { buffer.clear(); }
+    void putU8(uint8_t value) { buffer.push_back(value); }
+    void putString(const String& value);
+
+    const uint8_t* data() const { return buffer.data(); }
+    size_t size() const { return buffer.size(); }
+
+private:
+    std::vector<uint8_t> buffer;
+};
+
+// Liest Felder aus einem Record-Payload, prüft dabei die Grenzen
+class RecordParser {
+public:
+    RecordParser(const uint8_t* data, size_t len) : data(data), len(len), pos(0) {}
+
+    bool getU8(uint8_t& value);
+    bool getString(String& value);
+    // Record vollständig gelesen (später angehängte Felder sind optional)
+    bool atEnd() const { return pos >= len; }
+
+private:
+    const uint8_t* data;
+    size_t len;
+    size_t pos;
+};
+
+bool writeJournalHeader(File& file);
+bool appendJournalRecord(File& file, RecordType type, const RecordBuilder& payload);
+
+// Liest Records sequentiell. Ein unvollständiger oder fehlerhafter Record
+// (z.B. durch Stromausfall während des Schreibens) beendet das Lesen mit
+// Corrupt; alle Records davor sind gültig.
+class JournalReader {
+public:
+    enum class Result { Record, End, Corrupt };
+
+    explicit JournalReader(File& file) : file(file), validBytes(0) {}
+
+    bool begin();
+    Result next(RecordType& type, std::vector<uint8_t>& payload);
+    size_t getValidBytes() const { return validBytes; }
+
+private:
+    File& file;
+    size_t validBytes;
+};
+
+#endif
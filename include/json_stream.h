@@ -0,0 +1,53 @@
+#ifndef JSON_STREAM_H
+#define JSON_STREAM_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// Dokumentgröße pro Element (Strings werden nur referenziert, nicht kopiert)
+#define JSON_STREAM_DOC_SIZE    384
+// Puffer für ein serialisiertes Element. Größere Elemente werden in einen
+// passend allozierten Puffer serialisiert - ausgelassen wird keines.
+#define JSON_STREAM_ITEM_SIZE   1024
+
+// Ausgabeformat: JSON-Array oder NDJSON (ein Element pro Zeile)
+enum class JsonStreamFormat { Array, Lines };
+
+// Erzeugt ein JSON-Array Element für Element für eine Chunked Response.
+// Pro Aufruf von fill() werden nur so viele Elemente serialisiert, wie in
+// den Chunk passen - der Speicherbedarf ist unabhängig von der Anzahl.
+//
+// Verwendung:
+//   auto stream = std::make_shared<MyStream>();
+//   request->beginChunkedResponse("application/json",
+//       [stream](uint8_t* buffer, size_t maxLen, size_t index) {
+//           return stream->fill(buffer, maxLen);
+//       });
+class JsonArrayStream {
+public:
+    explicit JsonArrayStream(JsonStreamFormat format = JsonStreamFormat::Array);
+    virtual ~JsonArrayStream();
+
+    // Füllt buffer mit bis zu maxLen Bytes, 0 = Antwort vollständig
+    size_t fill(uint8_t* buffer, size_t maxLen);
+
+protected:
+    // Schreibt das nächste Element nach doc; false = keine weiteren Elemente.
+    // Referenzierte Strings müssen bis zum nächsten Aufruf gültig bleiben.
+    virtual bool nextItem(JsonDocument& doc) = 0;
+
+private:
+    enum class Stage { Open, Items, Close, Done };
+
+    JsonStreamFormat format;
+    Stage stage;
+    StaticJsonDocument<JSON_STREAM_DOC_SIZE> doc;
+    char itemBuffer[JSON_STREAM_ITEM_SIZE];
+    char* pending;          // itemBuffer oder (große Elemente) largeItem
+    char* largeItem;
+    size_t pendingLen;
+    size_t pendingPos;
+    size_t itemCount;
+};
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef NDJSON_H
+#define NDJSON_H
+
+#include <Arduino.h>
+
+// Maximale Länge einer NDJSON-Zeile (ein Datensatz)
+#define NDJSON_LINE_SIZE    512
+
+// Zerlegt einen Byte-Strom inkrementell in NDJSON-Zeilen. Chunks können an
+// beliebiger Stelle enden; gepuffert wird nur die aktuelle Zeile, nie der
+// ganze Body. Leerzeilen werden übersprungen (aber mitgezählt).
+class NdjsonLineReader {
+public:
+    NdjsonLineReader();
+    virtual ~NdjsonLineReader() {}
+
+    void feed(const uint8_t* data, size_t len);
+    // Gibt eine letzte Zeile ohne abschließendes '\n' aus
+    void finish();
+
+protected:
+    // line ist nullterminiert und darf verändert werden (z.B. zero-copy JSON).
+    // overflow = Zeile länger als NDJSON_LINE_SIZE, line ist dann leer.
+    virtual void onLine(uint32_t number, char* line, size_t len, bool overflow) = 0;
+
+private:
+    char line[NDJSON_LINE_SIZE];
+    size_t length;
+    bool overflow;
+    uint32_t lineNumber;
+
+    void emit();
+};
+
+#endif
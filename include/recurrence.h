@@ -0,0 +1,27 @@
+#ifndef RECURRENCE_H
+#define RECURRENCE_H
+
+#include <Arduino.h>
+#include "civil_date.h"
+
+// Wiederholregel eines Countdowns. Das gespeicherte Datum ist der Anker
+// (z.B. der Geburtstag), das nächste Auftreten wird bei Bedarf berechnet -
+// es wird nichts gespeichert, nur weil Zeit vergangen ist.
+enum class Recurrence : uint8_t {
+    None,
+    Yearly,
+    Monthly,
+    Weekly
+};
+
+// "yearly" / "monthly" / "weekly" (nur wenn recurring gesetzt ist)
+Recurrence parseRecurrence(bool recurring, const String& interval);
+
+// Erstes Auftreten am oder nach `today` (Epoch-Tage). Der Ereignistag selbst
+// zählt noch ("Heute!"), gewechselt wird ab dem folgenden Tag.
+// Existiert der Ankertag in einem Monat nicht, wird auf dessen letzten Tag
+// gekürzt: 31. -> 30./28./29., 29.02. -> 28.02. in Nicht-Schaltjahren. Die
+// Kürzung wirkt nur auf das jeweilige Auftreten, danach gilt wieder der Ankertag.
+int32_t nextOccurrence(int32_t anchorDay, Recurrence rule, int32_t today);
+
+#endif
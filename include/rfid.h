@@ -4,22 +4,93 @@
 #include <Arduino.h>
 #include <MFRC522.h>
 #include <SPI.h>
+#include "card_uid.h"
+#include "spsc_ring.h"
 
+// Ereignis des RFID-Tasks, Zeitstempel in micros() zum Zeitpunkt der Erkennung
+struct CardEvent {
+    enum class Type : uint8_t { Arrived, Removed };
+
+    Type type;
+    CardUid uid;
+    uint32_t timestamp;
+    uint32_t dwellMs;         // Nur bei Removed: wie lange die Karte auflag
+};
+
+// Zähler für die Zugriffe auf den RC522
+struct RfidStats {
+    uint32_t polls;           // Abfragen des Lesers
+    uint64_t spiTimeUs;       // Summe der Dauer aller Abfragen (SPI + Funk)
+    uint32_t spiMaxUs;        // Längste Abfrage
+    uint32_t contention;      // Zugriffe, die auf den Leser warten mussten
+    uint32_t reads;           // Gelesene Karten
+};
+
+// Der RC522 gehört ausschließlich dem RFID-Task: dieser fragt den Leser im
+// Abstand von RFID_POLL_INTERVAL_MS ab (oder wartet auf den IRQ-Pin) und legt
+// Ereignisse in einen Ringpuffer, den loop() abarbeitet. Ein blockierender
+// Display-Refresh verzögert dadurch nur die Anzeige, nicht die Erkennung.
 class RFIDReader {
 public:
     RFIDReader();
     bool begin();
-    bool cardPresent();
-    String readCardUID();
-    String getLastCardUID() const { return lastUID; }  // Letzten UID abrufen
-    unsigned long getLastReadTime() const { return lastReadTime; }  // Letzten Lesezeitpunkt
+    bool startTask();
+
+    // Nächstes Ereignis abholen (nur aus einem Task, z.B. loop())
+    bool pollEvent(CardEvent& event) { return events.pop(event); }
+    uint32_t getDroppedEvents() const { return events.getDropped(); }
+
+    // Zuletzt gelesene Karte (von beliebigen Tasks abrufbar)
+    String getLastCardUID();
+    unsigned long getLastReadTime();
+    bool isCardPresent() const { return presence == Presence::Present; }
+    // Wird bei jeder gelesenen Karte erhöht (zum Warten auf die nächste Karte)
+    uint32_t getReadCount();
+
+    // Firmware-Version des RC522 (einmal in begin() gelesen, kein SPI-Zugriff)
+    uint8_t getVersion() const { return version; }
+    RfidStats getStats();
+
+    static String uidToString(const CardUid& uid);
 
 private:
     MFRC522 mfrc522;
-    String lastUID;
+    SpscRing<CardEvent, 16> events;
+    TaskHandle_t task;
+    bool irqMode;
+    // Jeder Zugriff auf den RC522 hält diese Sperre (im Normalfall nur der Task)
+    SemaphoreHandle_t readerLock;
+    uint8_t version;
+
+    // Anwesenheit der Karte (nur der Task ändert den Zustand):
+    // Absent -> Arriving (erkannt, Entprellung läuft) -> Present -> Absent
+    enum class Presence : uint8_t { Absent, Arriving, Present };
+    volatile Presence presence;
+    CardUid presentUid;
+    uint32_t detectedAt;        // micros() beim ersten Kontakt
+    unsigned long arrivedAt;    // millis() beim ersten Kontakt
+    unsigned long lastSeen;     // millis() der letzten Antwort
+
+    // Letzte Karte und Zähler, geschützt durch lastLock
+    portMUX_TYPE lastLock;
+    CardUid lastUid;
     unsigned long lastReadTime;
+    RfidStats stats;
 
-    String uidToString(byte* uid, byte size);
+    static void taskEntry(void* param);
+    static void IRAM_ATTR irqHandler(void* param);
+    void taskLoop();
+    void lockReader();
+    void unlockReader();
+    uint8_t readVersion();
+    void poll(bool requested);
+    void beginArrival(const CardUid& uid, uint32_t pollStart, unsigned long now);
+    void confirmArrival();
+    bool requestCard(bool wakeup);
+    bool selectCard();
+    void haltCard();
+    void armIrq();
+    void publish(CardEvent::Type type, const CardUid& uid, uint32_t timestamp, uint32_t dwellMs);
 };
 
 extern RFIDReader rfidReader;
@@ -0,0 +1,86 @@
+#ifndef ROUTER_H
+#define ROUTER_H
+
+#include <Arduino.h>
+#include "webserver.h"
+#include "card_uid.h"
+#include "body_arena.h"
+
+class RouteRequest;
+
+typedef void (*RouteHandler)(RouteRequest& route);
+
+// Eintrag der statischen Routen-Tabelle. Das letzte Pfadsegment darf ein
+// Parameter sein ("/api/countdowns/:uid"), alle anderen sind fest.
+struct Route {
+    WebRequestMethodComposite method;
+    const char* pattern;
+    RouteHandler handler;
+    size_t maxBody;             // 0 = Request ohne Body (höchstens Arenagröße)
+};
+
+// Kontext eines gematchten Requests: Parameter und vollständiger Body
+class RouteRequest {
+public:
+    AsyncWebServerRequest* request;
+    // Body in der Arena des Requests. Veränderbar, damit JSON direkt darin
+    // (zero-copy) geparst werden kann; gültig bis der Handler zurückkehrt.
+    uint8_t* body;
+    size_t bodyLength;
+
+    // Wert des :param Segments (zeigt in die URL des Requests, nicht nullterminiert)
+    const char* param() const { return paramValue; }
+    size_t paramLength() const { return paramLen; }
+    String paramString() const;
+    bool paramUid(CardUid& out) const { return CardUid::fromHex(paramValue, paramLen, out); }
+
+private:
+    friend class Router;
+    const char* paramValue;
+    size_t paramLen;
+};
+
+// AsyncWebHandler, der alle Routen der Tabelle bedient. Die Zuordnung erfolgt
+// über eine Hash-Tabelle aus (Methode, Pfad) - höchstens zwei Hash-Lookups pro
+// Request (exakter Pfad, danach Pfad ohne letztes Segment für :param Routen),
+// unabhängig von der Anzahl der Routen und ohne Allokation.
+// Bodies werden für alle Routen einheitlich in einer Arena aus einem festen
+// Pool gesammelt. Zu große Bodies werden schon beim ersten Chunk anhand der
+// Content-Length verworfen (413, ohne Speicher zu belegen), ist kein Puffer
+// frei, antwortet der Router mit 503.
+class Router : public AsyncWebHandler {
+public:
+    Router();
+    ~Router();
+
+    bool begin(const Route* routes, size_t count, size_t arenaCount, size_t arenaSize);
+
+    bool canHandle(AsyncWebServerRequest* request) const override;
+    void handleRequest(AsyncWebServerRequest* request) override;
+    void handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) override;
+    bool isRequestHandlerTrivial() const override { return false; }
+
+    uint32_t getRejectedCount() const { return rejected; }
+    uint32_t getBusyCount() const { return arenas.getExhaustedCount(); }
+
+private:
+    struct Slot {
+        uint32_t key;
+        int16_t route;          // -1 = leer
+    };
+
+    const Route* routes;
+    size_t routeCount;
+    Slot* slots;
+    uint32_t mask;
+    BodyArenaPool arenas;
+    uint32_t rejected;
+
+    void releaseBody(AsyncWebServerRequest* request);
+    const Route* match(AsyncWebServerRequest* request, size_t* paramOffset) const;
+    const Route* lookup(uint32_t key, uint32_t method, const char* path, size_t len, bool wildcard) const;
+    static uint32_t routeKey(uint32_t method, const char* path, size_t len, bool wildcard);
+    static size_t prefixLength(const char* pattern, bool* wildcard);
+};
+
+#endif
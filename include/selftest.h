@@ -0,0 +1,18 @@
+#ifndef SELFTEST_H
+#define SELFTEST_H
+
+// Selbsttests beim Start. Nur in der Umgebung esp32dev-selftest aktiv
+// (pio run -e esp32dev-selftest -t upload), Ergebnis im Serial Monitor.
+
+#ifdef UID_SELFTEST
+// Prüft, dass der RFID-Pfad (UID -> Ereignis -> Lookup) ohne Heap-Allokation auskommt
+bool runUidSelfTest();
+#endif
+
+#ifdef DATE_SELFTEST
+// Vergleicht die Kalenderrechnung (civil_date.h) für jeden Tag von 1970 bis
+// 2100 mit einem einfachen Tag-für-Tag-Kalender und gmtime_r()
+bool runDateSelfTest();
+#endif
+
+#endif
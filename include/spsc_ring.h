@@ -0,0 +1,49 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Lock-freier Ringpuffer für genau einen Produzenten und einen Konsumenten
+// (z.B. RFID-Task -> loop()). N muss eine Zweierpotenz sein. Ist der Puffer
+// voll, wird das neue Element verworfen und gezählt.
+template <typename T, size_t N>
+class SpscRing {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "N muss eine Zweierpotenz sein");
+
+public:
+    SpscRing() : head(0), tail(0), dropped(0) {}
+
+    // Nur vom Produzenten aufrufen
+    bool push(const T& item) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= N) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        items[h & (N - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Nur vom Konsumenten aufrufen
+    bool pop(T& item) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = items[t & (N - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    uint32_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    T items[N];
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> tail;
+    std::atomic<uint32_t> dropped;
+};
+
+#endif
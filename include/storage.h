@@ -3,16 +3,44 @@
 
 #include <Arduino.h>
 #include <ArduinoJson.h>
+#include <FS.h>
 #include <vector>
+#include "card_uid.h"
+#include "civil_date.h"
+#include "recurrence.h"
+#include "uid_index.h"
+#include "journal.h"
 
 struct Countdown {
     String uid;           // RFID UID (8 bytes hex string)
     String name;          // Name (z.B. "Laras Geburtstag")
     String targetDate;    // Datum im Format "YYYY-MM-DD"
+    String targetTime;    // Uhrzeit "HH:MM" (optional, leer = ganzer Tag)
     String imagePath;     // Pfad zum Bild (optional, z.B. "/images/birthday.bmp")
     bool active;          // Ist dieser Countdown aktiv?
     bool recurring;       // Wiederkehrendes Ereignis (z.B. Geburtstag)
     String recurringInterval; // Intervall: "yearly", "monthly", "weekly"
+    CardUid uidKey;       // Binäre UID (wird vom StorageManager aus uid gesetzt)
+    int32_t targetDay;    // targetDate als Epoch-Tag (ebenso, INVALID_EPOCH_DAY bei ungültigem Datum)
+    Recurrence recurrence; // recurring + recurringInterval (ebenso)
+    int16_t targetMinute; // targetTime als Minute des Tages (ebenso, NO_TIME_OF_DAY ohne Uhrzeit)
+};
+
+// Zähler für das verzögerte Schreiben (Write-Behind)
+struct StorageStats {
+    uint32_t mutations;       // Änderungen insgesamt
+    uint32_t coalesced;       // Änderungen, die in einem bereits ausstehenden Record aufgingen
+    uint32_t flushes;         // Schreibvorgänge ins Journal
+    uint32_t recordsWritten;  // Geschriebene Records
+    uint32_t compactions;     // Geschriebene Snapshots
+};
+
+// Zustand des (höchstens einen) laufenden Bulk-Imports
+enum class ImportState : uint8_t {
+    Idle,
+    Pending,        // Angenommen, der Storage-Task schreibt noch
+    Committed,      // Geschrieben und übernommen
+    Failed          // Schreiben fehlgeschlagen, nichts übernommen
 };
 
 class StorageManager {
@@ -24,22 +52,94 @@ public:
     bool addCountdown(const Countdown& countdown);
     bool updateCountdown(const String& uid, const Countdown& countdown);
     bool deleteCountdown(const String& uid);
-    Countdown* getCountdownByUID(const String& uid);
+    // Übernimmt alle Countdowns (neu oder aktualisiert) in einer Transaktion.
+    // Prüft sofort (Kapazität, Größe) und übergibt sie dem Storage-Task: der
+    // schreibt sie mit dem aktuellen Zustand als neuen Snapshot und übernimmt
+    // sie erst danach in den RAM - entweder alle oder keiner.
+    // false = abgelehnt; das Ergebnis des Schreibens liefert getImportState().
+    bool importCountdowns(std::vector<Countdown>&& list);
+    ImportState getImportState() const { return importState; }
+    // Kopie eines aktiven Countdowns (unter dem Mutex). Keine Zeiger in den
+    // Vektor herausgeben: der Web-Task kann ihn jederzeit umbauen.
+    bool getCountdownByUID(const String& uid, Countdown& out);
+    bool getCountdownByUID(const CardUid& uid, Countdown& out);
+    // Nur prüfen, ob ein aktiver Countdown existiert (ohne Kopie/Allokation)
+    bool hasCountdown(const CardUid& uid);
     std::vector<Countdown> getAllCountdowns();
+    // Einzelzugriff per Position, z.B. zum Streamen ohne Kopie der ganzen Liste
+    size_t getCountdownCount();
+    bool getCountdownAt(size_t index, Countdown& out);
 
     // WiFi Settings
     bool saveWiFiCredentials(const String& ssid, const String& password);
     bool getWiFiCredentials(String& ssid, String& password);
 
-    // Save/Load
-    bool saveToFile();
-    bool loadFromFile();
+    // Änderungen werden nur im RAM markiert und von einem Hintergrund-Task
+    // nach STORAGE_FLUSH_QUIET_MS Ruhe (spätestens STORAGE_FLUSH_MAX_DELAY_MS)
+    // geschrieben. flush() schreibt sofort, z.B. vor einem Neustart.
+    // Mit STORAGE_WRITE_BEHIND false gibt es keinen Task: jede Änderung (auch
+    // ein Import) wird synchron im aufrufenden Task geschrieben.
+    bool flush();
+    bool isDirty();
+    StorageStats getStats();
+
+    // Wird bei jeder Änderung erhöht (z.B. für ETags der REST API)
+    uint32_t getGeneration() const { return generation; }
+
+    // Schreibt den aktuellen Zustand als neuen Snapshot und leert das Journal
+    bool compact();
+
+    // Legacy JSON-Format (Migrationspfad / Backup)
+    bool exportLegacyJson(const char* path);
+    bool importLegacyJson(const char* path);
 
 private:
     std::vector<Countdown> countdowns;
+    UidIndex uidIndex;
     String wifiSSID;
     String wifiPassword;
 
+    File journal;
+    RecordBuilder record;
+
+    // Write-Behind
+    SemaphoreHandle_t mutex;
+    TaskHandle_t flushTask;
+    std::vector<String> pendingUids;    // UIDs mit ungeschriebenen Änderungen
+    bool wifiDirty;
+    unsigned long firstDirtyTime;
+    unsigned long lastMutationTime;
+    StorageStats stats;
+    volatile uint32_t generation;
+
+    // Bulk-Import, vom Storage-Task geschrieben
+    std::vector<Countdown> importBatch;
+    volatile ImportState importState;
+
+    bool loadStore();
+    int findIndex(const String& uid);
+
+    // Zustand ändern (ohne Persistenz, auch beim Replay verwendet)
+    bool applyPut(const Countdown& countdown);
+    bool applyDelete(const String& uid);
+
+    // Journal
+    bool openJournal();
+    bool replayFile(const char* path);
+    void applyRecord(RecordType type, RecordParser& parser);
+    void encodeCountdown(const Countdown& countdown);
+    bool appendDelete(const String& uid);
+    bool appendWiFi();
+    bool appendRecord(RecordType type);
+
+    void markDirty(const String& uid);
+    void markWiFiDirty();
+    bool scheduleFlush();
+    void commitImport();
+    bool writeSnapshot(const std::vector<Countdown>* extra);
+    static void flushTaskEntry(void* param);
+    void flushLoop();
+
     String serializeToJson();
     bool deserializeFromJson(const String& json);
 };
@@ -0,0 +1,76 @@
+#ifndef TIME_SOURCE_H
+#define TIME_SOURCE_H
+
+#include <Arduino.h>
+#include <time.h>
+
+// Herkunft der aktuellen Uhrzeit
+enum class TimeQuality : uint8_t {
+    Invalid,    // Keine brauchbare Zeit (erster Start ohne Netzwerk)
+    Restored,   // Letzte gute Zeit aus dem NVS (nach Stromausfall, geht nach)
+    Retained,   // Uhr lief über einen Software-Neustart weiter (RTC-Timer)
+    Synced      // Per SNTP gestellt
+};
+
+// Zeitquelle: Zeitzone (POSIX-TZ, im NVS), SNTP mit Überwachung und Backoff,
+// letzte gute Zeit und Gangabweichung im NVS. Tagesberechnungen funktionieren
+// damit nach einem Neustart auch ohne Netzwerk; solange isValid() false
+// liefert, darf keine Tageszahl angezeigt werden.
+// Alle Methoden außer setTimeZone() und den Gettern laufen im loop()-Task.
+class TimeSource {
+public:
+    TimeSource();
+    // Zeitzone setzen und Uhr ggf. wiederherstellen (nach timerService.begin())
+    void begin();
+    // Nach dem Verbindungsaufbau: SNTP starten
+    void startSync();
+    // TIMER_TIME_SOURCE fällig: Zeit sichern, Synchronisation überwachen
+    void service();
+    // TIMER_TIME_CHANGED: neue Zeitzone übernehmen, SNTP-Ergebnis auswerten
+    void handleTimeChanged();
+
+    bool isValid() const { return quality != TimeQuality::Invalid; }
+    bool isSynced() const { return quality == TimeQuality::Synced; }
+    TimeQuality getQuality() const { return quality; }
+    static const char* qualityName(TimeQuality quality);
+
+    String getTimeZone();
+    // Aus dem Webserver-Task: speichert die Zeitzone, übernommen wird sie in loop()
+    bool setTimeZone(const String& tz);
+    static bool isValidTimeZone(const char* tz);
+
+    time_t getLastSync() const { return lastSyncTime; }
+    uint32_t getSyncCount() const { return syncCount; }
+    float getDriftPpm() const { return driftPpm; }
+
+private:
+    volatile TimeQuality quality;
+    bool syncStarted;
+    uint32_t retryDelay;            // s, aktueller Backoff
+    time_t lastSyncTime;
+    time_t lastSaveTime;
+    int64_t lastSyncUs;             // NTP-Zeit der letzten Synchronisation (µs)
+    int64_t lastSyncMono;           // esp_timer-Zeit der letzten Synchronisation
+    int64_t lastCorrectionMono;     // letzte Drift-Korrektur im Offline-Betrieb
+    uint32_t syncCount;
+    float driftPpm;                 // Gang der lokalen Uhr gegenüber NTP (+ = geht vor)
+
+    // Vom SNTP-Callback (lwIP-Task) gesetzt, in handleTimeChanged() ausgewertet
+    portMUX_TYPE syncLock;
+    volatile bool syncPending;
+    int64_t syncUs;
+    int64_t syncMono;
+
+    // Neue Zeitzone aus dem Webserver-Task
+    volatile bool tzPending;
+
+    void applyTimeZone();
+    void saveState(time_t now);
+    void scheduleService(uint32_t seconds);
+    void correctDrift();
+    static void onSync(struct timeval* tv);
+};
+
+extern TimeSource timeSource;
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef TIMER_SERVICE_H
+#define TIMER_SERVICE_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <time.h>
+#include <atomic>
+
+// Termine von loop() nach lokaler Uhrzeit (Tageswechsel, Nacht-Slot ...)
+enum TimerEvent : uint8_t {
+    TIMER_MIDNIGHT = 0,
+    TIMER_FULL_REFRESH,
+    TIMER_TIME_SOURCE,          // Zeit sichern / SNTP überwachen (TimeSource)
+    TIMER_COUNTDOWN_CLOCK,      // Stunden-Countdown: Beginn bzw. nächste Aktualisierung
+    TIMER_EVENT_COUNT
+};
+
+// Bits im Ergebnis von waitForEvents()
+#define TIMER_DUE(event)        (1u << (event))
+#define TIMER_TIME_CHANGED      (1u << 31)  // Uhr gestellt (NTP) oder Zeitzone geändert
+#define TIMER_CONFIG_CHANGED    (1u << 30)  // Countdowns o.ä. über das Webinterface geändert
+
+// Weckt loop() genau dann, wenn etwas zu tun ist. Ein einzelner esp_timer
+// steht auf dem frühesten Termin; andere Tasks (RFID, Display, WiFi) melden
+// neue Arbeit über wake(). Dazwischen blockiert loop() in waitForEvents()
+// und die CPU bleibt im Idle-Task (Voraussetzung für Light-Sleep).
+// Termine sind Wanduhrzeiten: feuert der Timer zu früh, weil die Uhr
+// inzwischen gestellt wurde, wird er einfach neu gestellt.
+class TimerService {
+public:
+    TimerService();
+    // Aus dem loop()-Task aufrufen: dieser Task wird geweckt
+    bool begin();
+
+    void scheduleAt(TimerEvent event, time_t when);
+    void cancel(TimerEvent event);
+
+    // Uhr oder Zeitzone hat sich geändert - loop() berechnet die Termine neu
+    void timeChanged();
+    // Konfiguration geändert (aus dem Web-Task) - loop() liest den angezeigten Countdown neu
+    void configChanged();
+
+    // loop() aufwecken (aus beliebigen Tasks, nicht aus ISRs)
+    void wake();
+
+    // Blockiert bis zu timeoutMs (portMAX_DELAY = unbegrenzt) oder bis zum
+    // nächsten wake(); liefert die seitdem fälligen TIMER_* Bits
+    uint32_t waitForEvents(uint32_t timeoutMs);
+
+private:
+    esp_timer_handle_t timer;
+    TaskHandle_t owner;
+    SemaphoreHandle_t mutex;
+    time_t deadlines[TIMER_EVENT_COUNT];    // 0 = nicht geplant
+    std::atomic<uint32_t> pending;
+
+    void arm();
+    void fire();
+    static void onTimer(void* arg);
+};
+
+extern TimerService timerService;
+
+#endif
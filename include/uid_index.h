@@ -0,0 +1,41 @@
+#ifndef UID_INDEX_H
+#define UID_INDEX_H
+
+#include <Arduino.h>
+#include <vector>
+#include "card_uid.h"
+
+struct Countdown;
+
+// Kompakter Open-Addressing Hash-Index (lineares Sondieren) von binärer UID
+// auf die Position im Countdown-Vektor. Pro Slot 4 Bytes: Position + 16 Bit
+// des Hashes, damit beim Sondieren kaum Schlüssel verglichen werden müssen.
+// Die Schlüssel selbst liegen in Countdown::uidKey.
+class UidIndex {
+public:
+    static const uint16_t EMPTY = 0xFFFF;
+
+    UidIndex();
+    ~UidIndex();
+
+    // capacity: maximale Anzahl Einträge (Tabelle wird >= 2x so groß)
+    bool begin(size_t capacity);
+
+    void clear();
+    void insert(const CardUid& key, uint16_t position);
+    // Liefert die Position im Vektor oder -1
+    int find(const CardUid& key, const std::vector<Countdown>& countdowns) const;
+    // Nach Löschen (Positionen verschieben sich) komplett neu aufbauen - O(n)
+    void rebuild(const std::vector<Countdown>& countdowns);
+
+private:
+    struct Slot {
+        uint16_t position;
+        uint16_t tag;       // Obere 16 Bit des Hashes
+    };
+
+    Slot* slots;
+    uint16_t mask;          // Tabellengröße - 1 (Zweierpotenz)
+};
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <Arduino.h>
+
+// Ins Flash eingebettete, gzip-komprimierte Dateien des Webinterfaces.
+// Die Tabelle (web_assets_data.h) erzeugt scripts/embed_web_assets.py beim Build.
+struct WebAsset {
+    const char* path;
+    const char* contentType;
+    const uint8_t* data;      // gzip
+    size_t length;
+    const char* etag;         // Hash über den unkomprimierten Inhalt
+    bool immutable;           // Versionierte URL, darf unbegrenzt gecacht werden
+};
+
+// FNV-1a, zur Compile-Zeit für die case-Labels und zur Laufzeit für die Anfrage
+constexpr uint32_t webPathHash(const char* path, uint32_t hash = 2166136261u) {
+    return *path ? webPathHash(path + 1, (hash ^ (uint8_t)*path) * 16777619u) : hash;
+}
+
+// Schützt vor Hash-Kollisionen mit unbekannten Pfaden
+inline const WebAsset* matchWebAsset(const WebAsset& asset, const char* expected, const char* path) {
+    return strcmp(expected, path) == 0 ? &asset : nullptr;
+}
+
+#endif
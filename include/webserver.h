@@ -22,6 +22,17 @@ typedef enum {
 #include <LittleFS.h>
 #include <ArduinoJson.h>
 
+struct CardEvent;
+
+// Zustand der Netzwerkverbindung. begin() blockiert nicht: die STA-Verbindung
+// läuft im Hintergrund, handle() schaltet auf Connected oder - nach
+// WIFI_CONNECT_TIMEOUT_MS ohne Verbindung - auf den Access Point weiter.
+enum class NetworkState : uint8_t {
+    Connecting,
+    Connected,
+    AccessPoint
+};
+
 class WebServerManager {
 public:
     WebServerManager();
@@ -29,21 +40,42 @@ public:
     void handle();
 
     bool startAP();
-    bool connectToWiFi(const String& ssid, const String& password);
     String getIPAddress();
+    bool isAPMode() const { return apMode; }
+    NetworkState getNetworkState() const { return netState; }
+    bool isNetworkReady() const { return netState != NetworkState::Connecting; }
+
+    void handleScanCard(AsyncWebServerRequest* request);
+
+    // Server-Sent Events unter /api/events (card-detected, card-removed,
+    // display-refreshed, config-changed). Aus beliebigen Tasks aufrufbar.
+    void publishCardEvent(const CardEvent& event);
+    void publishDisplayRefreshed(bool partial, uint32_t durationMs, uint32_t count);
+    void publishConfigChanged(const char* what);
 
 private:
     AsyncWebServer server;
+    AsyncEventSource events;
+    uint32_t eventId;
     bool apMode;
 
+    // WiFi-Zustandsautomat (siehe handle())
+    NetworkState netState;
+    String staSSID;
+    String staPassword;
+    unsigned long connectStarted;
+    bool fastConnect;               // Verbindung mit gecachter BSSID/Kanal
+    volatile bool staGotIp;         // aus dem WiFi-Event-Task gesetzt
+    volatile bool staDisconnected;
+
+    void startConnect(bool useCache);
+    void onConnected();
+    bool loadConnectCache(uint8_t* bssid, int32_t& channel);
+    void saveConnectCache();
+
+    void publish(const char* type, const String& data);
+
     void setupRoutes();
-    void handleGetCountdowns(AsyncWebServerRequest* request);
-    void handleAddCountdown(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total);
-    void handleUpdateCountdown(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total);
-    void handleDeleteCountdown(AsyncWebServerRequest* request);
-    void handleGetWiFi(AsyncWebServerRequest* request);
-    void handleSetWiFi(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total);
-    void handleScanCard(AsyncWebServerRequest* request);
 };
 
 extern WebServerManager webServer;
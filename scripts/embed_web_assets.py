@@ -0,0 +1,110 @@
+"""
+Bettet das Webinterface (web/) vorkomprimiert in die Firmware ein.
+
+Wird von PlatformIO vor jedem Build ausgeführt (extra_scripts = pre:...)
+und kann auch direkt aufgerufen werden:  python scripts/embed_web_assets.py
+
+- Verweise in index.html auf CSS/JS erhalten einen Inhalts-Hash (?v=...),
+  dadurch können diese Dateien im Browser unbegrenzt gecacht werden
+- Alle Dateien werden mit gzip komprimiert (reproduzierbar, mtime = 0)
+- Ergebnis: include/web_assets_data.h mit einer Tabelle im Flash
+"""
+
+import gzip
+import hashlib
+import os
+import re
+
+ASSETS = [
+    # (Datei, URL-Pfade, Content-Type, unveränderlich)
+    ("index.html", ["/", "/index.html"], "text/html; charset=utf-8", False),
+    ("style.css", ["/style.css"], "text/css; charset=utf-8", True),
+    ("script.js", ["/script.js"], "application/javascript; charset=utf-8", True),
+]
+
+
+def content_hash(data):
+    return hashlib.sha256(data).hexdigest()[:16]
+
+
+def version_references(html, hashes):
+    # href="style.css" -> href="style.css?v=<hash>"
+    def replace(match):
+        attr, name = match.group(1), match.group(2)
+        if name in hashes:
+            return '%s="%s?v=%s"' % (attr, name, hashes[name][:8])
+        return match.group(0)
+
+    return re.sub(r'(href|src)="([^"?]+)"', replace, html.decode("utf-8")).encode("utf-8")
+
+
+def c_array(name, data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append("    " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",")
+    return "static const uint8_t %s[] PROGMEM = {\n%s\n};\n" % (name, "\n".join(lines))
+
+
+def generate(project_dir):
+    web_dir = os.path.join(project_dir, "web")
+    output = os.path.join(project_dir, "include", "web_assets_data.h")
+
+    raw = {}
+    for filename, _, _, _ in ASSETS:
+        with open(os.path.join(web_dir, filename), "rb") as f:
+            raw[filename] = f.read()
+
+    hashes = {name: content_hash(data) for name, data in raw.items() if name != "index.html"}
+    raw["index.html"] = version_references(raw["index.html"], hashes)
+
+    parts = [
+        "// Automatisch erzeugt von scripts/embed_web_assets.py - nicht bearbeiten!\n",
+        "#ifndef WEB_ASSETS_DATA_H\n#define WEB_ASSETS_DATA_H\n\n",
+        '#include "web_assets.h"\n\n',
+    ]
+
+    entries = []
+    cases = []
+    total_raw = 0
+    total_gz = 0
+    for index, (filename, paths, content_type, immutable) in enumerate(ASSETS):
+        data = raw[filename]
+        compressed = gzip.compress(data, compresslevel=9, mtime=0)
+        symbol = "WEB_ASSET_%d" % index
+        parts.append(c_array(symbol, compressed))
+        parts.append("\n")
+        entries.append('    { "%s", "%s", %s, sizeof(%s), "\\"%s\\"", %s },'
+                       % (paths[-1], content_type, symbol, symbol, content_hash(data),
+                          "true" if immutable else "false"))
+        for path in paths:
+            cases.append('        case webPathHash("%s"): return matchWebAsset(WEB_ASSETS[%d], "%s", path);'
+                         % (path, index, path))
+        total_raw += len(data)
+        total_gz += len(compressed)
+
+    parts.append("static const WebAsset WEB_ASSETS[] = {\n%s\n};\n\n" % "\n".join(entries))
+    parts.append(
+        "// Die case-Labels werden zur Compile-Zeit gehasht\n"
+        "inline const WebAsset* findWebAsset(const char* path) {\n"
+        "    switch (webPathHash(path)) {\n%s\n"
+        "        default: return nullptr;\n"
+        "    }\n"
+        "}\n\n#endif\n" % "\n".join(cases))
+
+    content = "".join(parts)
+    # Nur schreiben wenn geändert, sonst baut PlatformIO jedes Mal neu
+    if os.path.exists(output):
+        with open(output, "r") as f:
+            if f.read() == content:
+                return
+    with open(output, "w") as f:
+        f.write(content)
+    print("Web-Assets eingebettet: %d Bytes -> %d Bytes gzip" % (total_raw, total_gz))
+
+
+try:
+    Import("env")  # noqa: F821 - von PlatformIO bereitgestellt
+    generate(env.subst("$PROJECT_DIR"))  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        generate(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
@@ -0,0 +1,72 @@
+#include "body_arena.h"
+#include <esp_heap_caps.h>
+
+BodyArenaPool::BodyArenaPool()
+    : arenas(nullptr), arenaCount(0), arenaSize(0), memory(nullptr), exhausted(0),
+      lock(portMUX_INITIALIZER_UNLOCKED) {
+}
+
+BodyArenaPool::~BodyArenaPool() {
+    delete[] arenas;
+    if (memory) {
+        heap_caps_free(memory);
+    }
+}
+
+bool BodyArenaPool::begin(size_t count, size_t size) {
+    if (memory) {
+        return true;
+    }
+
+    // Ein zusammenhängender Block für alle Arenen, bevorzugt PSRAM
+    memory = (uint8_t*)heap_caps_malloc(count * size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!memory) {
+        memory = (uint8_t*)heap_caps_malloc(count * size, MALLOC_CAP_8BIT);
+    }
+    if (!memory) {
+        Serial.println("Body-Arenen konnten nicht angelegt werden!");
+        return false;
+    }
+
+    arenas = new BodyArena[count];
+    for (size_t i = 0; i < count; i++) {
+        arenas[i].data = memory + i * size;
+        arenas[i].capacity = size;
+        arenas[i].length = 0;
+        arenas[i].received = 0;
+        arenas[i].inUse = false;
+    }
+    arenaCount = count;
+    arenaSize = size;
+    return true;
+}
+
+BodyArena* BodyArenaPool::acquire() {
+    BodyArena* result = nullptr;
+
+    portENTER_CRITICAL(&lock);
+    for (size_t i = 0; i < arenaCount; i++) {
+        if (!arenas[i].inUse) {
+            arenas[i].inUse = true;
+            arenas[i].length = 0;
+            arenas[i].received = 0;
+            result = &arenas[i];
+            break;
+        }
+    }
+    if (!result) {
+        exhausted++;
+    }
+    portEXIT_CRITICAL(&lock);
+
+    return result;
+}
+
+void BodyArenaPool::release(BodyArena* arena) {
+    if (!arena) {
+        return;
+    }
+    portENTER_CRITICAL(&lock);
+    arena->inUse = false;
+    portEXIT_CRITICAL(&lock);
+}
@@ -0,0 +1,120 @@
+#include "civil_date.h"
+
+static int digitsValue(const char* text, size_t count, bool* ok) {
+    int value = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!isdigit((uint8_t)text[i])) {
+            *ok = false;
+            return 0;
+        }
+        value = value * 10 + (text[i] - '0');
+    }
+    return value;
+}
+
+int32_t parseIsoDate(const char* text, size_t len) {
+    if (len != 10 || text[4] != '-' || text[7] != '-') {
+        return INVALID_EPOCH_DAY;
+    }
+
+    bool ok = true;
+    int year = digitsValue(text, 4, &ok);
+    int month = digitsValue(text + 5, 2, &ok);
+    int day = digitsValue(text + 8, 2, &ok);
+    if (!ok || month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month)) {
+        return INVALID_EPOCH_DAY;
+    }
+    return daysFromCivil(year, month, day);
+}
+
+int16_t parseTimeOfDay(const char* text, size_t len) {
+    if (len != 5 || text[2] != ':') {
+        return NO_TIME_OF_DAY;
+    }
+
+    bool ok = true;
+    int hour = digitsValue(text, 2, &ok);
+    int minute = digitsValue(text + 3, 2, &ok);
+    if (!ok || hour > 23 || minute > 59) {
+        return NO_TIME_OF_DAY;
+    }
+    return hour * 60 + minute;
+}
+
+// Grenzen des zuletzt berechneten lokalen Tages [dayStart, dayEnd)
+static time_t dayStart = 0;
+static time_t dayEnd = 0;
+static int32_t cachedDay = INVALID_EPOCH_DAY;
+
+int32_t localEpochDay(time_t now) {
+    if (cachedDay != INVALID_EPOCH_DAY && now >= dayStart && now < dayEnd) {
+        return cachedDay;
+    }
+
+    struct tm local;
+    localtime_r(&now, &local);
+    cachedDay = daysFromCivil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+
+    // Mitternacht heute und morgen über mktime(): berücksichtigt Tage mit
+    // 23 bzw. 25 Stunden bei der Sommerzeit-Umstellung
+    struct tm boundary = local;
+    boundary.tm_hour = 0;
+    boundary.tm_min = 0;
+    boundary.tm_sec = 0;
+    boundary.tm_isdst = -1;
+    dayStart = mktime(&boundary);
+    boundary = local;
+    boundary.tm_mday += 1;
+    boundary.tm_hour = 0;
+    boundary.tm_min = 0;
+    boundary.tm_sec = 0;
+    boundary.tm_isdst = -1;
+    dayEnd = mktime(&boundary);
+
+    if (dayStart > now || dayEnd <= now) {
+        // Sollte nicht vorkommen - dann beim nächsten Aufruf neu berechnen
+        dayStart = dayEnd = now;
+    }
+    return cachedDay;
+}
+
+void invalidateLocalDay() {
+    cachedDay = INVALID_EPOCH_DAY;
+}
+
+time_t localTimeOf(int32_t epochDay, int minuteOfDay) {
+    if (epochDay > TIME_T_MAX_EPOCH_DAY) {
+        return 0;
+    }
+    CivilDate date = civilFromDays(epochDay);
+    struct tm local = {};
+    local.tm_year = date.year - 1900;
+    local.tm_mon = date.month - 1;
+    local.tm_mday = date.day;
+    local.tm_hour = minuteOfDay / 60;
+    local.tm_min = minuteOfDay % 60;
+    local.tm_isdst = -1;
+    return mktime(&local);
+}
+
+time_t nextLocalTime(time_t now, int hour, int minute) {
+    struct tm local;
+    localtime_r(&now, &local);
+
+    struct tm target = local;
+    target.tm_hour = hour;
+    target.tm_min = minute;
+    target.tm_sec = 0;
+    target.tm_isdst = -1;
+    time_t when = mktime(&target);
+    if (when <= now) {
+        target = local;
+        target.tm_mday += 1;
+        target.tm_hour = hour;
+        target.tm_min = minute;
+        target.tm_sec = 0;
+        target.tm_isdst = -1;
+        when = mktime(&target);
+    }
+    return when;
+}
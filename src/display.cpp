@@ -1,16 +1,30 @@
 #include "display.h"
+#include "timer_service.h"
 #include "config.h"
 #include <time.h>
 #include <LittleFS.h>
+#include "image_scaler.h"
+#include "image_transcoder.h"
 
 DisplayManager displayManager;
 
-DisplayManager::DisplayManager() {
+DisplayManager::DisplayManager()
+    : gfx(nullptr), canvas(nullptr), panelQueue(nullptr), panelTask(nullptr), panelBusy(false),
+      panelRefreshCount(0), lastRefreshPartial(false), lastRefreshMs(0), frontBuffer(-1), pipelineReady(false),
+      countdownShown(false), shownWithImage(false), shownDays(0), shownMinutes(-1), shownDate(INVALID_EPOCH_DAY),
+      partialRefreshCount(0), clockRefreshCount(0), fullRefreshPending(false),
+      budgetDay(INVALID_EPOCH_DAY), budgetUsed(0) {
     // GxEPD2_750_T7: Waveshare 7.5" V2 (800x480)
     // Verwende HSPI-Bus für das Waveshare E-Paper ESP32 Driver Board
     display = new GxEPD2_BW<GxEPD2_750_T7, GxEPD2_750_T7::HEIGHT>(
         GxEPD2_750_T7(EPD_CS_PIN, EPD_DC_PIN, EPD_RST_PIN, EPD_BUSY_PIN)
     );
+    gfx = display;
+
+    for (int i = 0; i < 2; i++) {
+        framebuffers[i] = nullptr;
+        bufferFree[i] = nullptr;
+    }
 }
 
 bool DisplayManager::begin() {
@@ -22,47 +36,183 @@ bool DisplayManager::begin() {
     display->setRotation(0);
     display->setTextColor(GxEPD_BLACK);
 
+    // Render-Pipeline: zwei 1bpp Framebuffer (je 48 KB, bevorzugt PSRAM)
+    // und ein Panel-Task, der Übertragung + Refresh übernimmt
+    bool buffersOk = true;
+    for (int i = 0; i < 2; i++) {
+        framebuffers[i] = new FrameBuffer(GxEPD2_750_T7::WIDTH, GxEPD2_750_T7::HEIGHT);
+        if (!framebuffers[i]->begin()) {
+            buffersOk = false;
+            break;
+        }
+        framebuffers[i]->setTextColor(GxEPD_BLACK);
+        framebuffers[i]->setTextWrap(false);
+        bufferFree[i] = xSemaphoreCreateBinary();
+        xSemaphoreGive(bufferFree[i]);
+    }
+
+    if (buffersOk) {
+        panelQueue = xQueueCreate(2, sizeof(PanelJob));
+        pipelineReady = panelQueue != nullptr &&
+            xTaskCreatePinnedToCore(panelTaskEntry, "epd_panel", DISPLAY_TASK_STACK, this,
+                                    DISPLAY_TASK_PRIORITY, &panelTask, DISPLAY_TASK_CORE) == pdPASS;
+    }
+
+    if (pipelineReady) {
+        Serial.print("Framebuffer bereit (");
+        Serial.print(framebuffers[0]->isInPSRAM() ? "PSRAM" : "interner RAM");
+        Serial.println(", Double Buffering)");
+    } else {
+        // Fallback: direkt über das GxEPD2 Paging zeichnen
+        for (int i = 0; i < 2; i++) {
+            delete framebuffers[i];
+            framebuffers[i] = nullptr;
+        }
+        Serial.println("WARNUNG: Kein Framebuffer verfügbar - verwende Paging");
+    }
+
     Serial.println("E-Ink Display initialisiert");
     return true;
 }
 
+void DisplayManager::present(const std::function<void()>& draw, bool partial,
+                             int16_t x, int16_t y, int16_t w, int16_t h) {
+    unsigned long start = millis();
+
+    if (!pipelineReady) {
+        // Fallback: GxEPD2 Paging (Zeichnen und Refresh blockierend)
+        gfx = display;
+        if (partial) {
+            display->setPartialWindow(x, y, w, h);
+        } else {
+            display->setFullWindow();
+        }
+        display->firstPage();
+        do {
+            draw();
+        } while (display->nextPage());
+        lastRefreshPartial = partial;
+        lastRefreshMs = millis() - start;
+        panelRefreshCount++;
+        return;
+    }
+
+    // Freien Puffer holen: ist nicht der zuletzt komponierte, damit dieser
+    // ggf. noch vom Panel übertragen werden kann
+    uint8_t back = (frontBuffer == 0) ? 1 : 0;
+    xSemaphoreTake(bufferFree[back], portMAX_DELAY);
+
+    // Partial: Rest des Bildschirms vom vorherigen Frame übernehmen
+    if (partial && frontBuffer >= 0) {
+        framebuffers[back]->copyFrom(*framebuffers[frontBuffer]);
+    }
+
+    gfx = framebuffers[back];
+    canvas = framebuffers[back];
+    draw();
+    gfx = display;
+    canvas = nullptr;
+
+    PanelJob job = { back, partial, x, y, w, h };
+    frontBuffer = back;
+    panelBusy = true;
+    xQueueSend(panelQueue, &job, portMAX_DELAY);
+
+    Serial.print("Screen komponiert in ");
+    Serial.print(millis() - start);
+    Serial.println(" ms, Übertragung läuft im Hintergrund");
+}
+
+void DisplayManager::panelTaskEntry(void* param) {
+    static_cast<DisplayManager*>(param)->panelLoop();
+}
+
+void DisplayManager::panelLoop() {
+    const int16_t W = GxEPD2_750_T7::WIDTH;
+    const int16_t H = GxEPD2_750_T7::HEIGHT;
+
+    for (;;) {
+        PanelJob job;
+        if (xQueueReceive(panelQueue, &job, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        panelBusy = true;
+        unsigned long start = millis();
+        const uint8_t* buf = framebuffers[job.buffer]->getBuffer();
+
+        // Entspricht GxEPD2_BW::display() bzw. displayWindow(), nur aus dem eigenen Puffer
+        if (job.partial) {
+            display->epd2.writeImagePart(buf, job.x, job.y, W, H, job.x, job.y, job.w, job.h);
+            display->epd2.refresh(job.x, job.y, job.w, job.h);
+            if (display->epd2.hasFastPartialUpdate) {
+                display->epd2.writeImagePartAgain(buf, job.x, job.y, W, H, job.x, job.y, job.w, job.h);
+            }
+        } else {
+            display->epd2.writeImage(buf, 0, 0, W, H);
+            display->epd2.refresh(false);
+            if (display->epd2.hasFastPartialUpdate) {
+                display->epd2.writeImageAgain(buf, 0, 0, W, H);
+            }
+            display->epd2.powerOff();
+        }
+
+        lastRefreshPartial = job.partial;
+        lastRefreshMs = millis() - start;
+        panelRefreshCount++;
+        timerService.wake();  // loop() meldet den Refresh an die Web-Clients
+        Serial.print(job.partial ? "Partial" : "Full");
+        Serial.print(" Refresh abgeschlossen in ");
+        Serial.print(millis() - start);
+        Serial.println(" ms");
+
+        xSemaphoreGive(bufferFree[job.buffer]);
+        panelBusy = uxQueueMessagesWaiting(panelQueue) > 0;
+    }
+}
+
+bool DisplayManager::isBusy() const {
+    return panelBusy;
+}
+
+void DisplayManager::waitUntilIdle() {
+    while (pipelineReady && panelBusy) {
+        delay(10);
+    }
+}
+
 void DisplayManager::showWelcomeScreen() {
-    display->setFullWindow();
-    display->firstPage();
-    do {
-        display->fillScreen(GxEPD_WHITE);
+    present([this]() {
+        gfx->fillScreen(GxEPD_WHITE);
         drawBorder();
 
-        display->setFont(&FreeSansBold24pt7b);
         drawCenteredText("Countdown Display", 200, &FreeSansBold24pt7b);
-
-        display->setFont(&FreeSans12pt7b);
         drawCenteredText("Bitte RFID Karte vorhalten", 280, &FreeSans12pt7b);
-
-        display->setFont(&FreeSans9pt7b);
         drawCenteredText("Zum Konfigurieren mit WiFi verbinden", 350, &FreeSans9pt7b);
-    } while (display->nextPage());
+    });
+
+    resetRefreshState(false);
 }
 
-void DisplayManager::showCountdown(const Countdown& countdown, int daysRemaining) {
-    display->setFullWindow();
-    display->firstPage();
-    do {
-        display->fillScreen(GxEPD_WHITE);
+void DisplayManager::showCountdown(const Countdown& countdown, int daysRemaining, int minutesRemaining) {
+    bool hasImage = false;
+    int32_t date = occurrenceDay(countdown);
+
+    present([&]() {
+        gfx->fillScreen(GxEPD_WHITE);
         drawBorder();
 
         // Titel - immer mittig und oben (größerer Font)
-        display->setFont(&FreeSansBold24pt7b);
         drawCenteredText(countdown.name, 80, &FreeSansBold24pt7b);
 
         // Prüfe ob Bild vorhanden
-        bool hasImage = false;
+        hasImage = false;
         if (countdown.imagePath.length() > 0) {
             Serial.print("Versuche Bild zu laden: ");
             Serial.println(countdown.imagePath);
             // Bild links unten anzeigen (bündig mit Datumszeile)
             // Position: x=60, y beginnt bei 180 (damit es bis zur Datumszeile bei ~430 reicht)
-            hasImage = drawBMPImage(countdown.imagePath, 60, 180, 250, 250);
+            hasImage = drawImage(countdown.imagePath, 60, 180, IMAGE_MAX_WIDTH, IMAGE_MAX_HEIGHT);
             if (hasImage) {
                 Serial.println("✓ Bild erfolgreich geladen und gezeichnet");
             } else {
@@ -75,207 +225,441 @@ void DisplayManager::showCountdown(const Countdown& countdown, int daysRemaining
         int16_t x1, y1;
         uint16_t w, h;
 
+        // Tage verbleibend + "Tage" Label (auch für Partial Refresh verwendet)
+        drawDaysBlock(daysRemaining, minutesRemaining, hasImage);
+
+        // Datum, mit Uhrzeit falls angegeben
+        String dateStr = formatDateGerman(date);
+        if (countdown.targetMinute != NO_TIME_OF_DAY) {
+            dateStr += ", " + countdown.targetTime + " Uhr";
+        }
+
         if (hasImage) {
             // Layout mit Bild: Text rechts vom Bild
             int textAreaX = 350;      // Startposition für Text rechts vom Bild
             int textAreaWidth = 400;  // Verfügbare Breite für Text
 
-            // Tage verbleibend - sehr große Anzeige
-            display->setFont(&FreeSansBold24pt7b);
-            String daysText = String(abs(daysRemaining));
-            display->getTextBounds(daysText, 0, 0, &x1, &y1, &w, &h);
-            display->setCursor(textAreaX + (textAreaWidth - w) / 2, 240);
-            display->print(daysText);
-
-            // "Tage" Label (größerer Font)
-            display->setFont(&FreeSansBold18pt7b);
-            String labelText = "Tage";
-            if (daysRemaining < 0) {
-                labelText = "Tage her";
-            } else if (daysRemaining == 0) {
-                labelText = "Heute!";
-            } else if (daysRemaining == 1) {
-                labelText = "Tag";
-            }
-            display->getTextBounds(labelText, 0, 0, &x1, &y1, &w, &h);
-            display->setCursor(textAreaX + (textAreaWidth - w) / 2, 300);
-            display->print(labelText);
-
             // Datum (größerer Font, bündig mit Bildunterkante)
-            display->setFont(&FreeSans18pt7b);
-            String dateStr = formatDateGerman(countdown.targetDate);
-            display->getTextBounds(dateStr, 0, 0, &x1, &y1, &w, &h);
-            display->setCursor(textAreaX + (textAreaWidth - w) / 2, 420);
-            display->print(dateStr);
+            gfx->setFont(&FreeSans18pt7b);
+            gfx->getTextBounds(dateStr, 0, 0, &x1, &y1, &w, &h);
+            gfx->setCursor(textAreaX + (textAreaWidth - w) / 2, 420);
+            gfx->print(dateStr);
 
         } else {
-            // Layout ohne Bild: Alles zentriert, größere Fonts
-
-            // Tage verbleibend - extra große Anzeige
-            display->setFont(&FreeSansBold24pt7b);
-            String daysText = String(abs(daysRemaining));
-            display->getTextBounds(daysText, 0, 0, &x1, &y1, &w, &h);
-            display->setCursor((800 - w) / 2, 260);
-            display->print(daysText);
-
-            // "Tage" Label (größerer Font)
-            display->setFont(&FreeSansBold18pt7b);
-            String labelText = "Tage";
-            if (daysRemaining < 0) {
-                labelText = "Tage her";
-            } else if (daysRemaining == 0) {
-                labelText = "Heute!";
-            } else if (daysRemaining == 1) {
-                labelText = "Tag";
-            }
-            drawCenteredText(labelText, 330, &FreeSansBold18pt7b);
-
-            // Datum (größerer Font)
-            display->setFont(&FreeSans18pt7b);
-            String dateStr = formatDateGerman(countdown.targetDate);
+            // Layout ohne Bild: Datum zentriert (größerer Font)
             drawCenteredText(dateStr, 390, &FreeSans18pt7b);
         }
+    });
+
+    resetRefreshState(true);
+    shownCountdown = countdown;
+    shownDays = daysRemaining;
+    shownMinutes = minutesRemaining;
+    shownDate = date;
+    shownWithImage = hasImage;
+}
+
+void DisplayManager::updateDaysRemaining(const Countdown& countdown, int daysRemaining) {
+    if (!isShowing(countdown)) {
+        Serial.println("Partial Refresh nicht möglich - zeichne Countdown komplett neu");
+        showCountdown(countdown, daysRemaining);
+        return;
+    }
+
+    if (daysRemaining == shownDays && shownMinutes < 0) {
+        return;  // Nichts zu tun
+    }
+
+    // Ghosting-Schutz: Ist kein Nacht-Slot konfiguriert oder wurde er zu lange
+    // verpasst, wird der fällige Full Refresh direkt hier ausgeführt
+    if (fullRefreshPending &&
+        (FULL_REFRESH_HOUR < 0 || partialRefreshCount >= 2 * PARTIAL_REFRESH_LIMIT) &&
+        takeFullRefreshBudget()) {
+        Serial.println("Full Refresh fällig (Ghosting-Schutz)");
+        showCountdown(countdown, daysRemaining);
+        return;
+    }
+
+    int16_t rx, ry, rw, rh;
+    getDaysBlockRegion(shownWithImage, rx, ry, rw, rh);
 
-    } while (display->nextPage());
+    unsigned long start = millis();
+    present([&]() {
+        gfx->fillRect(rx, ry, rw, rh, GxEPD_WHITE);
+        drawDaysBlock(daysRemaining, -1, shownWithImage);
+    }, true, rx, ry, rw, rh);
+
+    shownDays = daysRemaining;
+    shownMinutes = -1;
+    partialRefreshCount++;
+    if (partialRefreshCount >= PARTIAL_REFRESH_LIMIT) {
+        fullRefreshPending = true;
+    }
+
+    Serial.print("Partial Refresh angestoßen (");
+    Serial.print(millis() - start);
+    Serial.print(" ms), Anzahl seit Full Refresh: ");
+    Serial.println(partialRefreshCount);
+}
+
+void DisplayManager::updateTimeRemaining(const Countdown& countdown, int daysRemaining, int minutesRemaining) {
+    if (!isShowing(countdown)) {
+        Serial.println("Partial Refresh nicht möglich - zeichne Countdown komplett neu");
+        showCountdown(countdown, daysRemaining, minutesRemaining);
+        return;
+    }
+
+    if (minutesRemaining == shownMinutes) {
+        return;  // Nichts zu tun
+    }
+
+    // Ghosting-Schutz: die kleine Fläche verträgt viele Partial Refreshes, danach
+    // sofort ein Full Refresh - aber nur im Rahmen des Tagesbudgets
+    if (fullRefreshPending && clockRefreshCount >= CLOCK_PARTIAL_REFRESH_LIMIT &&
+        takeFullRefreshBudget()) {
+        Serial.println("Full Refresh fällig (Ghosting-Schutz, Stunden-Countdown)");
+        showCountdown(countdown, daysRemaining, minutesRemaining);
+        return;
+    }
+
+    // Wechsel aus der Tagesanzeige: Label ändert sich, ganzer Tage-Block.
+    // Danach nur noch die Uhrzeit.
+    bool clockOnly = shownMinutes >= 0;
+    int16_t rx, ry, rw, rh;
+    if (clockOnly) {
+        getClockRegion(shownWithImage, rx, ry, rw, rh);
+    } else {
+        getDaysBlockRegion(shownWithImage, rx, ry, rw, rh);
+    }
+
+    present([&]() {
+        gfx->fillRect(rx, ry, rw, rh, GxEPD_WHITE);
+        drawDaysBlock(daysRemaining, minutesRemaining, shownWithImage);
+    }, true, rx, ry, rw, rh);
+
+    shownDays = daysRemaining;
+    shownMinutes = minutesRemaining;
+    if (clockOnly) {
+        clockRefreshCount++;
+        if (clockRefreshCount >= CLOCK_PARTIAL_REFRESH_LIMIT) {
+            fullRefreshPending = true;
+        }
+    } else {
+        partialRefreshCount++;
+        if (partialRefreshCount >= PARTIAL_REFRESH_LIMIT) {
+            fullRefreshPending = true;
+        }
+    }
+
+    Serial.printf("Stunden-Countdown %02d:%02d (Partial Refresh %s, seit Full Refresh: %u + %u Uhrzeit)\n",
+                  minutesRemaining / 60, minutesRemaining % 60, clockOnly ? "Uhrzeit" : "Tage-Block",
+                  (unsigned)partialRefreshCount, (unsigned)clockRefreshCount);
+}
+
+void DisplayManager::performScheduledFullRefresh() {
+    if (!fullRefreshPending || !takeFullRefreshBudget()) {
+        return;
+    }
+
+    Serial.println("Geplanter Full Refresh gegen Ghosting");
+    if (countdownShown) {
+        Countdown countdown = shownCountdown;
+        showCountdown(countdown, shownDays, shownMinutes);
+    } else {
+        fullRefreshPending = false;
+        partialRefreshCount = 0;
+    }
 }
 
 void DisplayManager::showError(const String& message) {
-    display->setFullWindow();
-    display->firstPage();
-    do {
-        display->fillScreen(GxEPD_WHITE);
+    present([&]() {
+        gfx->fillScreen(GxEPD_WHITE);
         drawBorder();
 
-        display->setFont(&FreeSansBold18pt7b);
         drawCenteredText("Fehler", 200, &FreeSansBold18pt7b);
-
-        display->setFont(&FreeSans12pt7b);
         drawCenteredText(message, 280, &FreeSans12pt7b);
-    } while (display->nextPage());
+    });
+
+    resetRefreshState(false);
 }
 
 void DisplayManager::showNoCardScreen() {
-    display->setFullWindow();
-    display->firstPage();
-    do {
-        display->fillScreen(GxEPD_WHITE);
+    present([this]() {
+        gfx->fillScreen(GxEPD_WHITE);
         drawBorder();
 
-        display->setFont(&FreeSansBold18pt7b);
         drawCenteredText("Keine Karte zugeordnet", 220, &FreeSansBold18pt7b);
-
-        display->setFont(&FreeSans12pt7b);
         drawCenteredText("Bitte Karte im Webinterface", 280, &FreeSans12pt7b);
         drawCenteredText("konfigurieren", 320, &FreeSans12pt7b);
-    } while (display->nextPage());
+    });
+
+    resetRefreshState(false);
 }
 
 void DisplayManager::clear() {
-    display->clearScreen();
+    present([this]() {
+        gfx->fillScreen(GxEPD_WHITE);
+    });
+
+    resetRefreshState(false);
 }
 
-int DisplayManager::calculateDaysRemaining(const String& targetDate) {
-    // Parse target date (Format: YYYY-MM-DD)
-    int year, month, day;
-    if (sscanf(targetDate.c_str(), "%d-%d-%d", &year, &month, &day) != 3) {
+int DisplayManager::calculateDaysRemaining(const Countdown& countdown) {
+    if (countdown.targetDay == INVALID_EPOCH_DAY) {
         return -9999; // Fehler
     }
+    return occurrenceDay(countdown) - localEpochDay();
+}
 
-    // Aktuelles Datum
-    time_t now;
-    time(&now);
-    struct tm* timeinfo = localtime(&now);
-
-    // Berechne Zeitdifferenz
-    struct tm target = {0};
-    target.tm_year = year - 1900;
-    target.tm_mon = month - 1;
-    target.tm_mday = day;
-    target.tm_hour = 0;
-    target.tm_min = 0;
-    target.tm_sec = 0;
-
-    // Konvertiere zu time_t
-    time_t targetTime = mktime(&target);
-
-    // Setze aktuelle Zeit auf Mitternacht
-    struct tm currentDay = *timeinfo;
-    currentDay.tm_hour = 0;
-    currentDay.tm_min = 0;
-    currentDay.tm_sec = 0;
-    time_t currentTime = mktime(&currentDay);
+time_t DisplayManager::calculateTargetTime(const Countdown& countdown) {
+    if (countdown.targetDay == INVALID_EPOCH_DAY || countdown.targetMinute == NO_TIME_OF_DAY) {
+        return 0;
+    }
+    return localTimeOf(occurrenceDay(countdown), countdown.targetMinute);
+}
 
-    // Berechne Differenz in Tagen
-    double diffSeconds = difftime(targetTime, currentTime);
-    int days = (int)floor(diffSeconds / 86400.0); // floor() für korrekte Rundung bei negativen Zahlen
+int DisplayManager::calculateMinutesRemaining(const Countdown& countdown) {
+    time_t target = calculateTargetTime(countdown);
+    time_t remaining = target - time(nullptr);
+    if (target == 0 || remaining <= 0 || remaining > 24 * 3600) {
+        return -1;
+    }
+    return (int)((remaining + 59) / 60);
+}
 
-    return days;
+int32_t DisplayManager::occurrenceDay(const Countdown& countdown) {
+    return nextOccurrence(countdown.targetDay, countdown.recurrence, localEpochDay());
 }
 
 void DisplayManager::drawCenteredText(const String& text, int y, const GFXfont* font) {
-    display->setFont(font);
+    gfx->setFont(font);
     int16_t x1, y1;
     uint16_t w, h;
-    display->getTextBounds(text, 0, 0, &x1, &y1, &w, &h);
-    display->setCursor((800 - w) / 2, y);
-    display->print(text);
+    gfx->getTextBounds(text, 0, 0, &x1, &y1, &w, &h);
+    gfx->setCursor((800 - w) / 2, y);
+    gfx->print(text);
 }
 
 void DisplayManager::drawBorder() {
-    display->drawRect(10, 10, 780, 460, GxEPD_BLACK);
-    display->drawRect(12, 12, 776, 456, GxEPD_BLACK);
+    gfx->drawRect(10, 10, 780, 460, GxEPD_BLACK);
+    gfx->drawRect(12, 12, 776, 456, GxEPD_BLACK);
+}
+
+void DisplayManager::drawDaysBlock(int daysRemaining, int minutesRemaining, bool hasImage) {
+    int16_t x1, y1;
+    uint16_t w, h;
+
+    String daysText;
+    String labelText;
+    if (minutesRemaining >= 0) {
+        // Stunden-Countdown: HH:MM an der Stelle der Tageszahl
+        char clock[8];
+        snprintf(clock, sizeof(clock), "%02d:%02d", minutesRemaining / 60, minutesRemaining % 60);
+        daysText = clock;
+        labelText = "Std:Min";
+    } else {
+        daysText = String(abs(daysRemaining));
+        labelText = daysLabel(daysRemaining);
+    }
+
+    if (hasImage) {
+        // Layout mit Bild: Text rechts vom Bild
+        int textAreaX = 350;      // Startposition für Text rechts vom Bild
+        int textAreaWidth = 400;  // Verfügbare Breite für Text
+
+        // Tage verbleibend - sehr große Anzeige
+        gfx->setFont(&FreeSansBold24pt7b);
+        gfx->getTextBounds(daysText, 0, 0, &x1, &y1, &w, &h);
+        gfx->setCursor(textAreaX + (textAreaWidth - w) / 2, 240);
+        gfx->print(daysText);
+
+        // "Tage" Label (größerer Font)
+        gfx->setFont(&FreeSansBold18pt7b);
+        gfx->getTextBounds(labelText, 0, 0, &x1, &y1, &w, &h);
+        gfx->setCursor(textAreaX + (textAreaWidth - w) / 2, 300);
+        gfx->print(labelText);
+    } else {
+        // Tage verbleibend - extra große Anzeige
+        gfx->setFont(&FreeSansBold24pt7b);
+        gfx->getTextBounds(daysText, 0, 0, &x1, &y1, &w, &h);
+        gfx->setCursor((800 - w) / 2, 260);
+        gfx->print(daysText);
+
+        // "Tage" Label (größerer Font)
+        drawCenteredText(labelText, 330, &FreeSansBold18pt7b);
+    }
 }
 
-String DisplayManager::formatDateGerman(const String& date) {
-    // Format: YYYY-MM-DD -> DD.MM.YYYY
-    int year, month, day;
-    if (sscanf(date.c_str(), "%d-%d-%d", &year, &month, &day) != 3) {
-        return date; // Bei Fehler: Original zurückgeben
+void DisplayManager::getDaysBlockRegion(bool hasImage, int16_t& x, int16_t& y, int16_t& w, int16_t& h) {
+    // Umschließendes Rechteck von Tageszahl (Baseline 240/260) und Label (Baseline 300/330)
+    // inkl. Unterlängen. x und w sind Vielfache von 8 (Byte-Grenzen des Controllers).
+    if (hasImage) {
+        x = 344; y = 190; w = 408; h = 128;   // Textbereich rechts vom Bild (Bild endet bei x=310)
+    } else {
+        x = 40;  y = 210; w = 720; h = 136;   // Zentriert, innerhalb des Rahmens
     }
+}
 
-    char buffer[11]; // DD.MM.YYYY + \0
-    snprintf(buffer, sizeof(buffer), "%02d.%02d.%04d", day, month, year);
-    return String(buffer);
+void DisplayManager::getClockRegion(bool hasImage, int16_t& x, int16_t& y, int16_t& w, int16_t& h) {
+    // Nur die Zeile der Tageszahl bzw. Uhrzeit ("23:59", FreeSansBold24pt7b,
+    // Baseline 240/260), innerhalb von getDaysBlockRegion(); x und w in Bytes
+    if (hasImage) {
+        x = 448; y = 196; w = 208; h = 52;    // Zentriert um x=550
+    } else {
+        x = 304; y = 216; w = 192; h = 52;    // Zentriert um x=400
+    }
 }
 
-bool DisplayManager::drawBMPImage(const String& filename, int16_t x, int16_t y, int16_t maxWidth, int16_t maxHeight) {
-    // Öffne Datei
-    if (!LittleFS.exists(filename)) {
-        Serial.println("Bild nicht gefunden: " + filename);
+String DisplayManager::daysLabel(int daysRemaining) {
+    if (daysRemaining < 0) {
+        return "Tage her";
+    } else if (daysRemaining == 0) {
+        return "Heute!";
+    } else if (daysRemaining == 1) {
+        return "Tag";
+    }
+    return "Tage";
+}
+
+bool DisplayManager::isShowing(const Countdown& countdown) {
+    // Partial Refresh nur möglich, wenn genau dieser Countdown unverändert angezeigt wird
+    // (bei wiederkehrenden Ereignissen auch mit demselben nächsten Datum)
+    return countdownShown &&
+           shownCountdown.uid == countdown.uid &&
+           shownCountdown.name == countdown.name &&
+           shownCountdown.targetTime == countdown.targetTime &&
+           shownDate == occurrenceDay(countdown) &&
+           shownCountdown.imagePath == countdown.imagePath;
+}
+
+bool DisplayManager::takeFullRefreshBudget() {
+    // Ghosting-Schutz ohne Dauerflackern: höchstens FULL_REFRESH_DAILY_BUDGET
+    // Full Refreshes pro lokalem Tag (neue Karten zählen nicht)
+    int32_t today = localEpochDay();
+    if (today != budgetDay) {
+        budgetDay = today;
+        budgetUsed = 0;
+    }
+    if (budgetUsed >= FULL_REFRESH_DAILY_BUDGET) {
+        Serial.println("Full-Refresh-Budget für heute verbraucht - weiter mit Partial Refresh");
         return false;
     }
+    budgetUsed++;
+    return true;
+}
+
+void DisplayManager::resetRefreshState(bool showingCountdown) {
+    // Nach jedem Full Refresh ist das Panel wieder "sauber"
+    countdownShown = showingCountdown;
+    partialRefreshCount = 0;
+    clockRefreshCount = 0;
+    fullRefreshPending = false;
+}
 
+String DisplayManager::formatDateGerman(int32_t epochDay) {
+    // Epoch-Tag -> DD.MM.YYYY
+    CivilDate date = civilFromDays(epochDay);
+    char buffer[12]; // DD.MM.YYYY + \0
+    snprintf(buffer, sizeof(buffer), "%02u.%02u.%04ld",
+             (unsigned)date.day, (unsigned)date.month, (long)date.year);
+    return String(buffer);
+}
+
+bool DisplayManager::drawImage(const String& filename, int16_t x, int16_t y, int16_t maxWidth, int16_t maxHeight) {
+    // Öffne Datei (open() schlägt bei fehlender Datei fehl, kein extra exists())
     File file = LittleFS.open(filename, "r");
     if (!file) {
-        Serial.println("Fehler beim Öffnen der Bilddatei");
+        Serial.println("Bild nicht gefunden: " + filename);
+        return false;
+    }
+
+    // Format anhand der Signatur: natives CDI (beim Upload konvertiert) oder BMP
+    uint8_t magic[4] = {0};
+    file.read(magic, 4);
+    file.seek(0);
+
+    bool result;
+    if (memcmp(magic, CDI_MAGIC, 4) == 0) {
+        result = drawNativeImage(file, x, y, maxWidth, maxHeight);
+    } else {
+        result = drawBMPImage(file, x, y, maxWidth, maxHeight);
+    }
+    file.close();
+
+    if (result) {
+        Serial.println("Bild erfolgreich gezeichnet: " + filename);
+    }
+    return result;
+}
+
+bool DisplayManager::drawNativeImage(File& file, int16_t x, int16_t y, int16_t maxWidth, int16_t maxHeight) {
+    unsigned long startMicros = micros();
+
+    CdiHeader header;
+    if (!readCdiHeader(file, header)) {
+        Serial.println("Ungültige CDI-Datei");
         return false;
     }
 
+    // Zeilen liegen bereits top-down und byte-ausgerichtet vor: ein Lesezugriff,
+    // danach pro Zeile ein memcpy-artiger Blit
+    int16_t drawWidth = min<int16_t>(header.width, maxWidth);
+    int16_t drawHeight = min<int16_t>(header.height, maxHeight);
+    uint32_t size = (uint32_t)header.stride * drawHeight;
+
+    uint8_t* pixels = (uint8_t*)ps_malloc(size);
+    if (!pixels) {
+        pixels = (uint8_t*)malloc(size);
+    }
+    if (!pixels) {
+        return false;
+    }
+
+    bool ok = file.read(pixels, size) == size;
+    if (ok) {
+        for (int16_t row = 0; row < drawHeight; row++) {
+            blitPackedRow(x, y + row, pixels + row * header.stride, drawWidth, false);
+        }
+    }
+    free(pixels);
+
+    Serial.print("CDI Bild ");
+    Serial.print(header.width);
+    Serial.print("x");
+    Serial.print(header.height);
+    Serial.print(" gezeichnet in ");
+    Serial.print((micros() - startMicros) / 1000.0, 1);
+    Serial.println(" ms");
+    return ok;
+}
+
+bool DisplayManager::drawBMPImage(File& file, int16_t x, int16_t y, int16_t maxWidth, int16_t maxHeight) {
+    unsigned long startMicros = micros();
+
     // Lese BMP Header (14 Bytes)
     uint8_t bmpHeader[14];
     if (file.read(bmpHeader, 14) != 14) {
-        file.close();
         return false;
     }
 
     // Prüfe BMP Signatur
     if (bmpHeader[0] != 'B' || bmpHeader[1] != 'M') {
         Serial.println("Keine gültige BMP-Datei");
-        file.close();
         return false;
     }
 
     // Lese DIB Header (mindestens 40 Bytes)
     uint8_t dibHeader[40];
     if (file.read(dibHeader, 40) != 40) {
-        file.close();
         return false;
     }
 
     // Extrahiere Bildinformationen
+    uint32_t dibSize = *(uint32_t*)(dibHeader + 0);
     int32_t width = *(int32_t*)(dibHeader + 4);
     int32_t height = *(int32_t*)(dibHeader + 8);
     uint16_t bitsPerPixel = *(uint16_t*)(dibHeader + 14);
+    uint32_t compression = *(uint32_t*)(dibHeader + 16);
     uint32_t imageOffset = *(uint32_t*)(bmpHeader + 10);
 
     Serial.print("BMP Info: ");
@@ -287,71 +671,139 @@ bool DisplayManager::drawBMPImage(const String& filename, int16_t x, int16_t y,
     Serial.println(" Bits pro Pixel");
 
     // Prüfe, ob Bild monochrom ist (1 Bit pro Pixel)
-    if (bitsPerPixel != 1) {
+    if (bitsPerPixel != 1 || compression != 0 || width <= 0) {
         Serial.print("FEHLER: Bild hat ");
         Serial.print(bitsPerPixel);
         Serial.println(" Bits pro Pixel. Nur 1-bit (monochrom) wird unterstützt!");
         Serial.println("Bitte konvertiere das Bild zu 1-bit monochrom BMP");
-        file.close();
         return false;
     }
 
-    // Berechne skalierte Größe (falls nötig)
-    int16_t displayWidth = width;
-    int16_t displayHeight = abs(height);
-
-    if (displayWidth > maxWidth || displayHeight > maxHeight) {
-        float scaleX = (float)maxWidth / displayWidth;
-        float scaleY = (float)maxHeight / displayHeight;
-        float scale = (scaleX < scaleY) ? scaleX : scaleY;
-        displayWidth = (int16_t)(displayWidth * scale);
-        displayHeight = (int16_t)(displayHeight * scale);
+    // Palette (2 Einträge BGRA direkt nach dem DIB Header) bestimmt die Polarität:
+    // Framebuffer erwartet 1 = weiß. Ist Index 1 dunkel, müssen die Bits invertiert werden.
+    // Ohne lesbare Palette gilt die übliche Belegung 0 = schwarz, 1 = weiß.
+    bool invert = false;
+    uint8_t palette[8];
+    if (file.seek(14 + dibSize) && file.read(palette, 8) == 8) {
+        uint16_t luma0 = (palette[2] * 77 + palette[1] * 150 + palette[0] * 29) >> 8;
+        uint16_t luma1 = (palette[6] * 77 + palette[5] * 150 + palette[4] * 29) >> 8;
+        invert = luma1 < luma0;
     }
 
-    // Für einfache Implementierung: Zeichne das Bild 1:1 ohne Skalierung
-    // (Skalierung würde mehr Code erfordern)
-    if (width > maxWidth) width = maxWidth;
-    if (abs(height) > maxHeight) height = (height > 0) ? maxHeight : -maxHeight;
-
-    // Gehe zum Bildanfang
-    file.seek(imageOffset);
-
     // BMP ist von unten nach oben gespeichert
     bool topDown = (height < 0);
     if (topDown) height = -height;
 
-    // Berechne Row-Padding (BMP Zeilen sind auf 4 Bytes ausgerichtet)
-    int rowSize = ((width + 31) / 32) * 4;
+    if (width > BMP_MAX_SOURCE_SIZE || height > BMP_MAX_SOURCE_SIZE) {
+        Serial.println("FEHLER: Bild ist zu groß");
+        return false;
+    }
+
+    // Zielgröße: in maxWidth x maxHeight einpassen (Seitenverhältnis bleibt erhalten)
+    uint16_t drawWidth, drawHeight;
+    AreaDownscaler::fitInto(width, height, maxWidth, maxHeight, drawWidth, drawHeight);
+    bool scaling = (drawWidth != width || drawHeight != height);
+
+    // Große Bilder werden beim Lesen zeilenweise herunterskaliert (Flächenmittelung)
+    // und per Floyd-Steinberg wieder auf 1bpp gebracht - nur O(Zielbreite) Speicher
+    AreaDownscaler scaler;
+    FloydSteinbergDither dither;
+    uint8_t* packedRow = nullptr;
+    if (scaling) {
+        Serial.print("Skaliere auf ");
+        Serial.print(drawWidth);
+        Serial.print("x");
+        Serial.println(drawHeight);
+
+        packedRow = (uint8_t*)malloc((drawWidth + 7) / 8);
+        if (!packedRow || !scaler.begin(width, height, drawWidth, drawHeight) ||
+            !dither.begin(drawWidth, IMAGE_DITHER)) {
+            free(packedRow);
+            return false;
+        }
+    }
 
-    // Zeichne Bild Zeile für Zeile
-    uint8_t* rowBuffer = (uint8_t*)malloc(rowSize);
-    if (!rowBuffer) {
-        file.close();
+    // Berechne Row-Padding (BMP Zeilen sind auf 4 Bytes ausgerichtet)
+    uint32_t rowSize = ((width + 31) / 32) * 4;
+
+    // Pixel-Array in großen Blöcken lesen: komplett in PSRAM, wenn möglich,
+    // sonst in Blöcken von BMP_READ_CHUNK Bytes (mindestens eine Zeile).
+    // Beim Skalieren wird nie das ganze Bild geladen.
+    uint32_t totalSize = rowSize * height;
+    uint32_t chunkRows = (totalSize <= BMP_READ_CHUNK) ? height : BMP_READ_CHUNK / rowSize;
+    uint8_t* pixels = nullptr;
+    if (chunkRows < (uint32_t)height && !scaling) {
+        pixels = (uint8_t*)ps_malloc(totalSize);
+        if (pixels) chunkRows = height;
+    }
+    if (chunkRows == 0) chunkRows = 1;
+    if (!pixels) {
+        pixels = (uint8_t*)malloc(chunkRows * rowSize);
+    }
+    if (!pixels) {
+        free(packedRow);
         return false;
     }
 
-    for (int16_t row = 0; row < height; row++) {
-        // Lese Zeile
-        file.read(rowBuffer, rowSize);
+    // Gehe zum Bildanfang
+    file.seek(imageOffset);
 
-        int16_t drawY = topDown ? (y + row) : (y + height - 1 - row);
+    unsigned long readMicros = 0;
+    for (int32_t row = 0; row < height; row += chunkRows) {
+        uint32_t rows = min<uint32_t>(chunkRows, height - row);
+
+        unsigned long t = micros();
+        size_t got = file.read(pixels, rows * rowSize);
+        readMicros += micros() - t;
+        if (got < rows * rowSize) {
+            rows = got / rowSize;
+        }
 
-        // Zeichne Pixel
-        for (int16_t col = 0; col < width; col++) {
-            int byteIndex = col / 8;
-            int bitIndex = 7 - (col % 8);
-            bool pixelSet = (rowBuffer[byteIndex] >> bitIndex) & 1;
+        for (uint32_t i = 0; i < rows; i++) {
+            const uint8_t* rowData = pixels + i * rowSize;
 
-            // Schwarz zeichnen (invertiert, da BMP 0=schwarz, 1=weiß bei monochromen Bildern oft umgekehrt ist)
-            if (!pixelSet) {
-                display->drawPixel(x + col, drawY, GxEPD_BLACK);
+            if (scaling) {
+                if (scaler.pushRow1bpp(rowData, invert)) {
+                    uint16_t outRow = scaler.outputRowIndex();
+                    int16_t imageRow = topDown ? outRow : (drawHeight - 1 - outRow);
+                    dither.processRow(scaler.outputRow(), packedRow);
+                    blitPackedRow(x, y + imageRow, packedRow, drawWidth, false);
+                }
+            } else {
+                int32_t fileRow = row + i;
+                int32_t imageRow = topDown ? fileRow : (height - 1 - fileRow);
+                blitPackedRow(x, y + imageRow, rowData, drawWidth, invert);
             }
         }
+
+        if (rows < chunkRows) {
+            break;  // Datei kürzer als erwartet
+        }
     }
 
-    free(rowBuffer);
-    file.close();
+    free(packedRow);
+    free(pixels);
 
-    Serial.println("Bild erfolgreich gezeichnet: " + filename);
+    Serial.print("BMP gezeichnet (");
+    Serial.print((micros() - startMicros) / 1000.0, 1);
+    Serial.print(" ms gesamt, davon ");
+    Serial.print(readMicros / 1000.0, 1);
+    Serial.println(" ms Lesen)");
     return true;
 }
+
+void DisplayManager::blitPackedRow(int16_t x, int16_t y, const uint8_t* bits, int16_t w, bool invert) {
+    if (canvas) {
+        // Ganze Zeile als Bitmuster in den Framebuffer
+        canvas->drawRowBits(x, y, bits, w, invert);
+        return;
+    }
+
+    // Paging-Fallback: Pixel einzeln (nur schwarze Pixel)
+    for (int16_t col = 0; col < w; col++) {
+        bool white = ((bits[col >> 3] >> (7 - (col & 7))) & 1) != invert;
+        if (!white) {
+            gfx->drawPixel(x + col, y, GxEPD_BLACK);
+        }
+    }
+}
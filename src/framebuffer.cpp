@@ -0,0 +1,178 @@
+#include "framebuffer.h"
+#include <esp_heap_caps.h>
+
+FrameBuffer::FrameBuffer(int16_t width, int16_t height)
+    : Adafruit_GFX(width, height), buffer(nullptr), stride((width + 7) / 8), inPSRAM(false) {
+}
+
+FrameBuffer::~FrameBuffer() {
+    if (buffer) {
+        heap_caps_free(buffer);
+    }
+}
+
+bool FrameBuffer::begin() {
+    if (buffer) {
+        return true;
+    }
+
+    // Bevorzugt PSRAM (BOARD_HAS_PSRAM), sonst interner RAM als Fallback
+    buffer = (uint8_t*)heap_caps_malloc(getSize(), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    inPSRAM = (buffer != nullptr);
+    if (!buffer) {
+        buffer = (uint8_t*)heap_caps_malloc(getSize(), MALLOC_CAP_8BIT);
+    }
+    if (!buffer) {
+        return false;
+    }
+
+    memset(buffer, 0xFF, getSize());  // Weiß
+    return true;
+}
+
+void FrameBuffer::drawPixel(int16_t x, int16_t y, uint16_t color) {
+    if (!buffer || x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT) {
+        return;
+    }
+
+    uint8_t* ptr = &buffer[y * stride + (x >> 3)];
+    uint8_t mask = 0x80 >> (x & 7);
+    if (color) {
+        *ptr |= mask;    // Weiß
+    } else {
+        *ptr &= ~mask;   // Schwarz
+    }
+}
+
+void FrameBuffer::fillScreen(uint16_t color) {
+    if (buffer) {
+        memset(buffer, color ? 0xFF : 0x00, getSize());
+    }
+}
+
+void FrameBuffer::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+    fillRect(x, y, w, 1, color);
+}
+
+void FrameBuffer::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+    fillRect(x, y, 1, h, color);
+}
+
+void FrameBuffer::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    if (!buffer) {
+        return;
+    }
+
+    // Clipping
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > WIDTH) w = WIDTH - x;
+    if (y + h > HEIGHT) h = HEIGHT - y;
+    if (w <= 0 || h <= 0) {
+        return;
+    }
+
+    // Zeilenweise: Randbytes maskieren, volle Bytes per memset
+    int16_t firstByte = x >> 3;
+    int16_t lastByte = (x + w - 1) >> 3;
+    uint8_t firstMask = 0xFF >> (x & 7);
+    uint8_t lastMask = 0xFF << (7 - ((x + w - 1) & 7));
+    if (firstByte == lastByte) {
+        firstMask &= lastMask;
+    }
+
+    for (int16_t row = y; row < y + h; row++) {
+        uint8_t* line = &buffer[row * stride];
+        if (color) {
+            line[firstByte] |= firstMask;
+        } else {
+            line[firstByte] &= ~firstMask;
+        }
+        if (lastByte > firstByte) {
+            if (lastByte - firstByte > 1) {
+                memset(&line[firstByte + 1], color ? 0xFF : 0x00, lastByte - firstByte - 1);
+            }
+            if (color) {
+                line[lastByte] |= lastMask;
+            } else {
+                line[lastByte] &= ~lastMask;
+            }
+        }
+    }
+}
+
+void FrameBuffer::drawRowBits(int16_t x, int16_t y, const uint8_t* src, int16_t w, bool invert) {
+    if (!buffer || y < 0 || y >= HEIGHT || w <= 0) {
+        return;
+    }
+
+    // Clipping (links abgeschnittene Pixel in der Quelle überspringen)
+    int16_t srcBit = 0;
+    if (x < 0) {
+        srcBit = -x;
+        w += x;
+        x = 0;
+    }
+    if (x + w > WIDTH) w = WIDTH - x;
+    if (w <= 0) {
+        return;
+    }
+
+    uint8_t* line = &buffer[y * stride];
+
+    // Schneller Pfad: Quelle und Ziel auf Byte-Grenzen
+    if ((x & 7) == 0 && (srcBit & 7) == 0) {
+        const uint8_t* s = src + (srcBit >> 3);
+        uint8_t* d = line + (x >> 3);
+        int16_t fullBytes = w >> 3;
+        if (invert) {
+            for (int16_t i = 0; i < fullBytes; i++) {
+                d[i] = ~s[i];
+            }
+        } else {
+            memcpy(d, s, fullBytes);
+        }
+        int16_t rest = w & 7;
+        if (rest) {
+            uint8_t mask = 0xFF << (8 - rest);
+            uint8_t v = invert ? ~s[fullBytes] : s[fullBytes];
+            d[fullBytes] = (d[fullBytes] & ~mask) | (v & mask);
+        }
+        return;
+    }
+
+    // Allgemeiner Pfad: bis zu 8 Pixel pro Schritt per Bit-Shift
+    int16_t srcLen = (srcBit + w + 7) >> 3;
+    int16_t dstBit = x;
+    int16_t remaining = w;
+    while (remaining > 0) {
+        int16_t dstByte = dstBit >> 3;
+        int16_t offset = dstBit & 7;
+        int16_t n = 8 - offset;
+        if (n > remaining) n = remaining;
+
+        // 8 Quellbits ab beliebiger Bitposition
+        int16_t sb = srcBit >> 3;
+        int16_t sh = srcBit & 7;
+        uint8_t v = src[sb] << sh;
+        if (sh && sb + 1 < srcLen) {
+            v |= src[sb + 1] >> (8 - sh);
+        }
+        if (invert) {
+            v = ~v;
+        }
+
+        uint8_t mask = (0xFF >> offset) & (uint8_t)(0xFF << (8 - offset - n));
+        line[dstByte] = (line[dstByte] & ~mask) | ((v >> offset) & mask);
+
+        dstBit += n;
+        srcBit += n;
+        remaining -= n;
+    }
+}
+
+void FrameBuffer::copyFrom(const FrameBuffer& other) {
+    if (buffer && other.buffer && other.getSize() == getSize()) {
+        memcpy(buffer, other.buffer, getSize());
+    }
+}
@@ -0,0 +1,201 @@
+#include "image_scaler.h"
+
+AreaDownscaler::AreaDownscaler()
+    : srcW(0), srcH(0), dstW(0), dstH(0), srcRow(0), curRow(0), outIndex(0),
+      rowSum(nullptr), accum(nullptr), outRow(nullptr) {
+}
+
+AreaDownscaler::~AreaDownscaler() {
+    end();
+}
+
+bool AreaDownscaler::begin(uint16_t srcWidth, uint16_t srcHeight, uint16_t dstWidth, uint16_t dstHeight) {
+    end();
+
+    if (dstWidth == 0 || dstHeight == 0 || dstWidth > srcWidth || dstHeight > srcHeight) {
+        return false;
+    }
+
+    srcW = srcWidth;
+    srcH = srcHeight;
+    dstW = dstWidth;
+    dstH = dstHeight;
+    srcRow = 0;
+    curRow = 0;
+    outIndex = 0;
+
+    rowSum = (uint32_t*)malloc(dstW * sizeof(uint32_t));
+    accum = (uint32_t*)calloc(dstW, sizeof(uint32_t));
+    outRow = (uint8_t*)malloc(dstW);
+    if (!rowSum || !accum || !outRow) {
+        end();
+        return false;
+    }
+    return true;
+}
+
+void AreaDownscaler::end() {
+    free(rowSum);
+    free(accum);
+    free(outRow);
+    rowSum = nullptr;
+    accum = nullptr;
+    outRow = nullptr;
+}
+
+template <typename PixelFn>
+bool AreaDownscaler::pushRow(PixelFn pixel) {
+    if (!accum || srcRow >= srcH) {
+        return false;
+    }
+
+    // Horizontal: Quellpixel auf Zielspalten verteilen (max. 2 Spalten pro Pixel)
+    memset(rowSum, 0, dstW * sizeof(uint32_t));
+    uint16_t t = 0;
+    uint32_t boundary = srcW;             // Ende von Zielspalte t: (t + 1) * srcW
+    uint32_t pos = 0;                     // Anfang von Quellpixel x: x * dstW
+    for (uint16_t x = 0; x < srcW; x++) {
+        uint32_t g = pixel(x);
+        uint32_t next = pos + dstW;
+        if (next <= boundary) {
+            rowSum[t] += g * dstW;
+        } else {
+            uint32_t part = boundary - pos;
+            rowSum[t] += g * part;
+            t++;
+            boundary += srcW;
+            rowSum[t] += g * (dstW - part);
+        }
+        pos = next;
+        if (pos == boundary && t + 1 < dstW) {
+            t++;
+            boundary += srcW;
+        }
+    }
+
+    // Normieren auf 8.8 Festkomma (0..65280), damit die vertikale Summe in 32 Bit passt
+    for (uint16_t i = 0; i < dstW; i++) {
+        rowSum[i] = (rowSum[i] << 8) / srcW;
+    }
+
+    // Vertikal: Quellzeile überdeckt [srcRow*dstH, (srcRow+1)*dstH), Zielzeile [curRow*srcH, (curRow+1)*srcH)
+    uint32_t rowStart = (uint32_t)srcRow * dstH;
+    uint32_t rowEnd = rowStart + dstH;
+    uint32_t targetEnd = (uint32_t)(curRow + 1) * srcH;
+    srcRow++;
+
+    if (rowEnd < targetEnd) {
+        for (uint16_t i = 0; i < dstW; i++) {
+            accum[i] += rowSum[i] * dstH;
+        }
+        return false;
+    }
+
+    // Zielzeile abgeschlossen: Anteil bis zur Grenze addieren und ausgeben
+    uint32_t part = targetEnd - rowStart;
+    uint32_t rest = dstH - part;
+    uint32_t norm = (uint32_t)srcH << 8;
+    for (uint16_t i = 0; i < dstW; i++) {
+        uint32_t v = (accum[i] + rowSum[i] * part) / norm;
+        outRow[i] = (v > 255) ? 255 : v;
+        accum[i] = rowSum[i] * rest;   // Rest gehört zur nächsten Zielzeile
+    }
+    outIndex = curRow;
+    curRow++;
+    return true;
+}
+
+bool AreaDownscaler::pushRowGray(const uint8_t* gray) {
+    return pushRow([gray](uint16_t x) -> uint32_t { return gray[x]; });
+}
+
+bool AreaDownscaler::pushRow1bpp(const uint8_t* bits, bool invert) {
+    return pushRow([bits, invert](uint16_t x) -> uint32_t {
+        bool white = ((bits[x >> 3] >> (7 - (x & 7))) & 1) != invert;
+        return white ? 255 : 0;
+    });
+}
+
+void AreaDownscaler::fitInto(uint16_t srcWidth, uint16_t srcHeight, uint16_t maxWidth, uint16_t maxHeight,
+                             uint16_t& dstWidth, uint16_t& dstHeight) {
+    dstWidth = srcWidth;
+    dstHeight = srcHeight;
+    if (srcWidth == 0 || srcHeight == 0 || (srcWidth <= maxWidth && srcHeight <= maxHeight)) {
+        return;
+    }
+
+    // Skalierungsfaktor min(maxW/srcW, maxH/srcH) ganzzahlig per Kreuzprodukt
+    if ((uint32_t)maxWidth * srcHeight <= (uint32_t)maxHeight * srcWidth) {
+        dstWidth = maxWidth;
+        dstHeight = (uint32_t)srcHeight * maxWidth / srcWidth;
+    } else {
+        dstHeight = maxHeight;
+        dstWidth = (uint32_t)srcWidth * maxHeight / srcHeight;
+    }
+    if (dstWidth == 0) dstWidth = 1;
+    if (dstHeight == 0) dstHeight = 1;
+}
+
+FloydSteinbergDither::FloydSteinbergDither()
+    : width(0), enabled(true), errCur(nullptr), errNext(nullptr) {
+}
+
+FloydSteinbergDither::~FloydSteinbergDither() {
+    end();
+}
+
+bool FloydSteinbergDither::begin(uint16_t w, bool dither) {
+    end();
+    width = w;
+    enabled = dither;
+
+    // Je eine Zelle Rand links/rechts, damit die Fehlerverteilung ohne Abfragen auskommt
+    errCur = (int16_t*)calloc(width + 2, sizeof(int16_t));
+    errNext = (int16_t*)calloc(width + 2, sizeof(int16_t));
+    if (!errCur || !errNext) {
+        end();
+        return false;
+    }
+    return true;
+}
+
+void FloydSteinbergDither::end() {
+    free(errCur);
+    free(errNext);
+    errCur = nullptr;
+    errNext = nullptr;
+}
+
+void FloydSteinbergDither::processRow(const uint8_t* gray, uint8_t* packed) {
+    memset(packed, 0, (width + 7) / 8);
+
+    if (!enabled || !errCur) {
+        for (uint16_t x = 0; x < width; x++) {
+            if (gray[x] >= 128) {
+                packed[x >> 3] |= 0x80 >> (x & 7);
+            }
+        }
+        return;
+    }
+
+    for (uint16_t x = 0; x < width; x++) {
+        // Fehler sind in 1/16 gespeichert
+        int16_t value = gray[x] + (errCur[x + 1] + 8) / 16;
+        int16_t result = (value >= 128) ? 255 : 0;
+        if (result) {
+            packed[x >> 3] |= 0x80 >> (x & 7);
+        }
+
+        int16_t err = value - result;
+        errCur[x + 2] += err * 7;
+        errNext[x] += err * 3;
+        errNext[x + 1] += err * 5;
+        errNext[x + 2] += err * 1;
+    }
+
+    // Zeilen rotieren
+    int16_t* tmp = errCur;
+    errCur = errNext;
+    errNext = tmp;
+    memset(errNext, 0, (width + 2) * sizeof(int16_t));
+}
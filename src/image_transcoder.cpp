@@ -0,0 +1,408 @@
+#include "image_transcoder.h"
+#include "config.h"
+#include <esp_heap_caps.h>
+
+// Größter unterstützter Header: 14 + 124 (BITMAPV5HEADER) + 256 * 4 Palette
+static const size_t TRANSCODER_HEADER_MAX = 14 + 124 + 1024;
+static const size_t PGM_HEADER_MAX = 256;
+
+bool readCdiHeader(File& file, CdiHeader& header) {
+    uint8_t raw[CDI_HEADER_SIZE];
+    if (file.read(raw, CDI_HEADER_SIZE) != CDI_HEADER_SIZE || memcmp(raw, CDI_MAGIC, 4) != 0) {
+        return false;
+    }
+
+    header.width = raw[4] | (raw[5] << 8);
+    header.height = raw[6] | (raw[7] << 8);
+    header.stride = raw[8] | (raw[9] << 8);
+    return header.width > 0 && header.height > 0 && header.stride >= (header.width + 7) / 8;
+}
+
+static uint8_t lumaBGR(uint8_t b, uint8_t g, uint8_t r) {
+    return (r * 77 + g * 150 + b * 29) >> 8;
+}
+
+static uint16_t readLE16(const uint8_t* p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t readLE32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+ImageTranscoder::ImageTranscoder()
+    : state(State::Idle), format(Format::Unknown), maxW(0), maxH(0),
+      header(nullptr), headerLen(0), headerNeed(0),
+      srcW(0), srcH(0), bpp(0), topDown(false), pixelOffset(0), bytePos(0),
+      srcRowSize(0), srcRowsDone(0), pgmMaxVal(255),
+      rowBuf(nullptr), rowFill(0), grayRow(nullptr), image(nullptr),
+      outW(0), outH(0), outStride(0), scaling(false) {
+}
+
+ImageTranscoder::~ImageTranscoder() {
+    abort();
+}
+
+bool ImageTranscoder::begin(const String& outputPath, uint16_t maxWidth, uint16_t maxHeight) {
+    abort();
+
+    path = outputPath;
+    tempPath = outputPath + ".tmp";
+    maxW = maxWidth;
+    maxH = maxHeight;
+    error = "";
+    format = Format::Unknown;
+    headerLen = 0;
+    headerNeed = 2;     // Magic ("BM" oder "P5")
+    bytePos = 0;
+    srcRowsDone = 0;
+    rowFill = 0;
+
+    header = (uint8_t*)malloc(TRANSCODER_HEADER_MAX);
+    if (!header) {
+        return fail("Zu wenig Speicher");
+    }
+
+    state = State::Header;
+    return true;
+}
+
+bool ImageTranscoder::write(const uint8_t* data, size_t len) {
+    while (len > 0) {
+        size_t take = 0;
+
+        switch (state) {
+            case State::Header:
+                take = min(len, headerNeed - headerLen);
+                memcpy(header + headerLen, data, take);
+                headerLen += take;
+                if (headerLen == headerNeed && !parseHeader()) {
+                    return false;
+                }
+                break;
+
+            case State::Skip:
+                // Bytes zwischen Header und Pixel-Array überspringen
+                take = min<size_t>(len, pixelOffset - bytePos);
+                if (bytePos + take == pixelOffset) {
+                    state = State::Rows;
+                }
+                break;
+
+            case State::Rows:
+                take = min<size_t>(len, srcRowSize - rowFill);
+                memcpy(rowBuf + rowFill, data, take);
+                rowFill += take;
+                if (rowFill == srcRowSize) {
+                    rowFill = 0;
+                    if (!processRow()) {
+                        return false;
+                    }
+                    if (srcRowsDone == srcH) {
+                        state = State::Done;
+                    }
+                }
+                break;
+
+            case State::Done:
+                return true;   // Restliche Bytes (z.B. Padding am Dateiende) ignorieren
+
+            default:
+                return false;
+        }
+
+        data += take;
+        len -= take;
+        bytePos += take;
+    }
+    return true;
+}
+
+bool ImageTranscoder::finish() {
+    if (state != State::Done) {
+        return fail(state == State::Failed ? error : String("Bild unvollständig"));
+    }
+
+    // Ein einziger sequentieller Schreibvorgang: Zeilen von Bottom-up BMPs
+    // wurden im RAM an ihre top-down Position gelegt, nicht per seek() in
+    // die Datei (jeder Schreibzugriff mitten in eine LittleFS-Datei kopiert
+    // den Rest der Datei in neue Blöcke)
+    size_t size = CDI_HEADER_SIZE + (size_t)outH * outStride;
+    File out = LittleFS.open(tempPath, "w");
+    bool written = out && out.write(image, size) == size;
+    if (out) {
+        out.close();
+    }
+    releaseBuffers();
+    if (!written) {
+        LittleFS.remove(tempPath);
+        return fail("Schreibfehler");
+    }
+
+    // Erst jetzt die fertige Datei unter dem endgültigen Namen ablegen
+    LittleFS.remove(path);
+    if (!LittleFS.rename(tempPath, path)) {
+        LittleFS.remove(tempPath);
+        return fail("Konnte Datei nicht speichern");
+    }
+
+    state = State::Idle;
+    return true;
+}
+
+void ImageTranscoder::abort() {
+    releaseBuffers();
+    if (state != State::Failed) {
+        state = State::Idle;
+    }
+}
+
+bool ImageTranscoder::fail(const String& message) {
+    error = message;
+    state = State::Failed;
+    abort();
+    Serial.print("Bild-Konvertierung fehlgeschlagen: ");
+    Serial.println(message);
+    return false;
+}
+
+void ImageTranscoder::releaseBuffers() {
+    free(header);
+    free(rowBuf);
+    free(grayRow);
+    heap_caps_free(image);
+    header = nullptr;
+    rowBuf = nullptr;
+    grayRow = nullptr;
+    image = nullptr;
+    scaler.end();
+    dither.end();
+}
+
+bool ImageTranscoder::parseHeader() {
+    if (format == Format::Unknown) {
+        if (header[0] == 'B' && header[1] == 'M') {
+            format = Format::Bmp;
+            headerNeed = 14 + 4;    // Dateiheader + Größe des DIB Headers
+        } else if (header[0] == 'P' && header[1] == '5') {
+            format = Format::Pgm;
+            headerNeed = 3;
+        } else {
+            return fail("Nur BMP (1/8/24/32 Bit) und PGM werden unterstützt");
+        }
+        return true;
+    }
+
+    return (format == Format::Bmp) ? parseBmpHeader() : parsePgmHeader();
+}
+
+bool ImageTranscoder::parseBmpHeader() {
+    uint32_t dibSize = readLE32(header + 14);
+    if (dibSize < 40 || dibSize > 124) {
+        return fail("Nicht unterstützter BMP Header");
+    }
+    if (headerLen < 14 + dibSize) {
+        headerNeed = 14 + dibSize;
+        return true;
+    }
+
+    int32_t width = (int32_t)readLE32(header + 18);
+    int32_t height = (int32_t)readLE32(header + 22);
+    bpp = readLE16(header + 28);
+    uint32_t compression = readLE32(header + 30);
+    uint32_t colorsUsed = readLE32(header + 46);
+    pixelOffset = readLE32(header + 10);
+
+    if (compression != 0 || (bpp != 1 && bpp != 8 && bpp != 24 && bpp != 32)) {
+        return fail("Nur unkomprimierte BMPs mit 1, 8, 24 oder 32 Bit werden unterstützt");
+    }
+
+    // Palette (1 und 8 Bit) vollständig in den Header-Puffer lesen
+    uint32_t paletteEntries = 0;
+    if (bpp <= 8) {
+        paletteEntries = colorsUsed ? colorsUsed : (1u << bpp);
+        if (paletteEntries > 256) {
+            return fail("Ungültige BMP Palette");
+        }
+        size_t need = 14 + dibSize + paletteEntries * 4;
+        if (headerLen < need) {
+            headerNeed = need;
+            return true;
+        }
+    }
+
+    // Palette -> Helligkeit, nicht belegte Einträge sind schwarz
+    memset(paletteLuma, 0, sizeof(paletteLuma));
+    const uint8_t* pal = header + 14 + dibSize;
+    for (uint32_t i = 0; i < paletteEntries; i++) {
+        paletteLuma[i] = lumaBGR(pal[i * 4], pal[i * 4 + 1], pal[i * 4 + 2]);
+    }
+
+    topDown = height < 0;
+    srcW = width;
+    srcH = topDown ? -height : height;
+    srcRowSize = ((srcW * bpp + 31) / 32) * 4;
+
+    if (width <= 0 || srcH == 0 || pixelOffset < headerLen) {
+        return fail("Ungültige BMP Datei");
+    }
+
+    if (!startOutput()) {
+        return false;
+    }
+    state = (headerLen == pixelOffset) ? State::Rows : State::Skip;
+    return true;
+}
+
+bool ImageTranscoder::parsePgmHeader() {
+    // "P5 <Breite> <Höhe> <Maxwert>" + genau ein Whitespace, Kommentare mit '#'
+    uint32_t values[3];
+    int found = 0;
+    size_t i = 2;
+    while (i < headerLen && found < 3) {
+        char c = header[i];
+        if (c == '#') {
+            while (i < headerLen && header[i] != '\n') i++;
+            if (i == headerLen) break;   // Kommentar noch nicht vollständig
+            i++;
+        } else if (isspace(c)) {
+            i++;
+        } else if (isdigit(c)) {
+            uint32_t v = 0;
+            size_t start = i;
+            while (i < headerLen && isdigit(header[i])) {
+                v = v * 10 + (header[i] - '0');
+                i++;
+            }
+            if (i == headerLen) {
+                i = start;          // Zahl könnte noch weitergehen
+                break;
+            }
+            values[found++] = v;
+        } else {
+            return fail("Ungültiger PGM Header");
+        }
+    }
+
+    // Nach dem Maxwert muss genau ein Whitespace folgen, dann beginnen die Daten
+    if (found < 3 || i >= headerLen) {
+        if (headerLen >= PGM_HEADER_MAX) {
+            return fail("Ungültiger PGM Header");
+        }
+        headerNeed = headerLen + 1;
+        return true;
+    }
+
+    srcW = values[0];
+    srcH = values[1];
+    pgmMaxVal = values[2];
+    if (!isspace(header[i]) || srcW == 0 || srcH == 0 || pgmMaxVal == 0 || pgmMaxVal > 255) {
+        return fail("Nur 8-Bit PGM (P5) wird unterstützt");
+    }
+
+    bpp = 8;
+    topDown = true;
+    srcRowSize = srcW;
+    pixelOffset = i + 1;     // headerLen == i + 1, Daten folgen direkt
+
+    if (!startOutput()) {
+        return false;
+    }
+    state = State::Rows;
+    return true;
+}
+
+bool ImageTranscoder::startOutput() {
+    if (srcW > BMP_MAX_SOURCE_SIZE || srcH > BMP_MAX_SOURCE_SIZE) {
+        return fail("Bild ist zu groß");
+    }
+
+    AreaDownscaler::fitInto(srcW, srcH, maxW, maxH, outW, outH);
+    scaling = (outW != srcW || outH != srcH);
+    outStride = (outW + 7) / 8;
+
+    Serial.print("Konvertiere ");
+    Serial.print(srcW);
+    Serial.print("x");
+    Serial.print(srcH);
+    Serial.print(" (");
+    Serial.print(bpp);
+    Serial.print(" Bit) nach ");
+    Serial.print(outW);
+    Serial.print("x");
+    Serial.println(outH);
+
+    // Ausgabe bevorzugt im PSRAM, sonst im internen Heap
+    size_t imageSize = CDI_HEADER_SIZE + (size_t)outH * outStride;
+    image = (uint8_t*)heap_caps_calloc(1, imageSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!image) {
+        image = (uint8_t*)heap_caps_calloc(1, imageSize, MALLOC_CAP_8BIT);
+    }
+
+    rowBuf = (uint8_t*)malloc(srcRowSize);
+    grayRow = (uint8_t*)malloc(srcW);
+    if (!image || !rowBuf || !grayRow || !dither.begin(outW, IMAGE_DITHER) ||
+        (scaling && !scaler.begin(srcW, srcH, outW, outH))) {
+        return fail("Zu wenig Speicher");
+    }
+
+    memcpy(image, CDI_MAGIC, 4);
+    image[4] = outW & 0xFF;
+    image[5] = outW >> 8;
+    image[6] = outH & 0xFF;
+    image[7] = outH >> 8;
+    image[8] = outStride & 0xFF;
+    image[9] = outStride >> 8;
+    return true;
+}
+
+bool ImageTranscoder::processRow() {
+    const uint8_t* src = rowBuf;
+
+    // Quellzeile -> Graustufen (0 = schwarz .. 255 = weiß)
+    switch (bpp) {
+        case 1:
+            for (uint32_t x = 0; x < srcW; x++) {
+                grayRow[x] = paletteLuma[(src[x >> 3] >> (7 - (x & 7))) & 1];
+            }
+            break;
+        case 8:
+            if (format == Format::Pgm) {
+                for (uint32_t x = 0; x < srcW; x++) {
+                    grayRow[x] = (pgmMaxVal == 255) ? src[x] : min<uint32_t>(255, src[x] * 255u / pgmMaxVal);
+                }
+            } else {
+                for (uint32_t x = 0; x < srcW; x++) {
+                    grayRow[x] = paletteLuma[src[x]];
+                }
+            }
+            break;
+        case 24:
+            for (uint32_t x = 0; x < srcW; x++) {
+                grayRow[x] = lumaBGR(src[x * 3], src[x * 3 + 1], src[x * 3 + 2]);
+            }
+            break;
+        case 32:
+            for (uint32_t x = 0; x < srcW; x++) {
+                grayRow[x] = lumaBGR(src[x * 4], src[x * 4 + 1], src[x * 4 + 2]);
+            }
+            break;
+    }
+
+    uint16_t index = srcRowsDone++;
+    if (!scaling) {
+        return emitRow(grayRow, index);
+    }
+    if (scaler.pushRowGray(grayRow)) {
+        return emitRow(scaler.outputRow(), scaler.outputRowIndex());
+    }
+    return true;
+}
+
+bool ImageTranscoder::emitRow(const uint8_t* gray, uint16_t sourceOrderIndex) {
+    // Fehlerdiffusion läuft in Empfangsreihenfolge (bei Bottom-up BMPs also
+    // nach oben) - optisch gleichwertig, spart aber jeden Zwischenpuffer
+    uint16_t row = topDown ? sourceOrderIndex : (outH - 1 - sourceOrderIndex);
+    dither.processRow(gray, image + CDI_HEADER_SIZE + (size_t)row * outStride);
+    return true;
+}
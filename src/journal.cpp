@@ -0,0 +1,109 @@
+#include "journal.h"
+#include <esp_rom_crc.h>
+
+static uint32_t recordCrc(uint8_t type, uint16_t len, const uint8_t* payload) {
+    uint8_t head[3] = { type, (uint8_t)(len & 0xFF), (uint8_t)(len >> 8) };
+    uint32_t crc = esp_rom_crc32_le(0, head, sizeof(head));
+    return esp_rom_crc32_le(crc, payload, len);
+}
+
+void RecordBuilder::putString(const String& value) {
+    uint16_t len = value.length();
+    buffer.push_back(len & 0xFF);
+    buffer.push_back(len >> 8);
+    const uint8_t* chars = (const uint8_t*)value.c_str();
+    buffer.insert(buffer.end(), chars, chars + len);
+}
+
+bool RecordParser::getU8(uint8_t& value) {
+    if (pos + 1 > len) {
+        return false;
+    }
+    value = data[pos++];
+    return true;
+}
+
+bool RecordParser::getString(String& value) {
+    if (pos + 2 > len) {
+        return false;
+    }
+    uint16_t strLen = data[pos] | (data[pos + 1] << 8);
+    pos += 2;
+    if (pos + strLen > len) {
+        return false;
+    }
+
+    value = String();
+    value.concat((const char*)data + pos, strLen);
+    pos += strLen;
+    return true;
+}
+
+bool writeJournalHeader(File& file) {
+    return file.write((const uint8_t*)JOURNAL_MAGIC, JOURNAL_MAGIC_SIZE) == JOURNAL_MAGIC_SIZE;
+}
+
+bool appendJournalRecord(File& file, RecordType type, const RecordBuilder& payload) {
+    if (payload.size() > JOURNAL_MAX_PAYLOAD) {
+        Serial.println("Journal: Record zu groß!");
+        return false;
+    }
+
+    uint16_t len = payload.size();
+    uint32_t crc = recordCrc((uint8_t)type, len, payload.data());
+
+    uint8_t head[JOURNAL_RECORD_HEADER];
+    head[0] = (uint8_t)type;
+    head[1] = len & 0xFF;
+    head[2] = len >> 8;
+    head[3] = crc & 0xFF;
+    head[4] = (crc >> 8) & 0xFF;
+    head[5] = (crc >> 16) & 0xFF;
+    head[6] = crc >> 24;
+
+    // Ein abgebrochener Record fällt beim Einlesen durch die CRC auf
+    if (file.write(head, JOURNAL_RECORD_HEADER) != JOURNAL_RECORD_HEADER) {
+        return false;
+    }
+    return len == 0 || file.write(payload.data(), len) == len;
+}
+
+bool JournalReader::begin() {
+    char magic[JOURNAL_MAGIC_SIZE];
+    file.seek(0);
+    if (file.read((uint8_t*)magic, JOURNAL_MAGIC_SIZE) != JOURNAL_MAGIC_SIZE ||
+        memcmp(magic, JOURNAL_MAGIC, JOURNAL_MAGIC_SIZE) != 0) {
+        return false;
+    }
+    validBytes = JOURNAL_MAGIC_SIZE;
+    return true;
+}
+
+JournalReader::Result JournalReader::next(RecordType& type, std::vector<uint8_t>& payload) {
+    uint8_t head[JOURNAL_RECORD_HEADER];
+    size_t got = file.read(head, JOURNAL_RECORD_HEADER);
+    if (got == 0) {
+        return Result::End;
+    }
+    if (got != JOURNAL_RECORD_HEADER) {
+        return Result::Corrupt;
+    }
+
+    uint16_t len = head[1] | (head[2] << 8);
+    uint32_t crc = head[3] | (head[4] << 8) | ((uint32_t)head[5] << 16) | ((uint32_t)head[6] << 24);
+    if (len > JOURNAL_MAX_PAYLOAD) {
+        return Result::Corrupt;
+    }
+
+    payload.resize(len);
+    if (len > 0 && file.read(payload.data(), len) != len) {
+        return Result::Corrupt;
+    }
+    if (recordCrc(head[0], len, payload.data()) != crc) {
+        return Result::Corrupt;
+    }
+
+    type = (RecordType)head[0];
+    validBytes += JOURNAL_RECORD_HEADER + len;
+    return Result::Record;
+}
@@ -0,0 +1,90 @@
+#include "json_stream.h"
+
+JsonArrayStream::JsonArrayStream(JsonStreamFormat format)
+    : format(format), stage(Stage::Open), pending(itemBuffer), largeItem(nullptr),
+      pendingLen(0), pendingPos(0), itemCount(0) {
+}
+
+JsonArrayStream::~JsonArrayStream() {
+    free(largeItem);
+}
+
+size_t JsonArrayStream::fill(uint8_t* buffer, size_t maxLen) {
+    size_t written = 0;
+
+    while (written < maxLen) {
+        // Rest des zuletzt serialisierten Elements ausgeben
+        if (pendingPos < pendingLen) {
+            size_t n = min(pendingLen - pendingPos, maxLen - written);
+            memcpy(buffer + written, pending + pendingPos, n);
+            pendingPos += n;
+            written += n;
+            continue;
+        }
+
+        pendingLen = 0;
+        pendingPos = 0;
+        if (largeItem) {
+            free(largeItem);
+            largeItem = nullptr;
+            pending = itemBuffer;
+        }
+
+        switch (stage) {
+            case Stage::Open:
+                if (format == JsonStreamFormat::Array) {
+                    pending[pendingLen++] = '[';
+                }
+                stage = Stage::Items;
+                break;
+
+            case Stage::Items: {
+                doc.clear();
+                if (!nextItem(doc)) {
+                    stage = Stage::Close;
+                    break;
+                }
+
+                // Trennzeichen, Element, Zeilenende und Nullterminator müssen in den Puffer passen
+                size_t capacity = measureJson(doc) + 3;
+                if (capacity > sizeof(itemBuffer)) {
+                    largeItem = (char*)ps_malloc(capacity);
+                    if (!largeItem) {
+                        largeItem = (char*)malloc(capacity);
+                    }
+                    if (!largeItem) {
+                        // Lieber eine abgebrochene (ungültige) Antwort als ein
+                        // stillschweigend fehlender Eintrag
+                        Serial.println("JSON Stream: kein Speicher für großes Element, Abbruch");
+                        stage = Stage::Done;
+                        return written;
+                    }
+                    pending = largeItem;
+                } else {
+                    capacity = sizeof(itemBuffer);
+                }
+                if (format == JsonStreamFormat::Array && itemCount > 0) {
+                    pending[pendingLen++] = ',';
+                }
+                itemCount++;
+                pendingLen += serializeJson(doc, pending + pendingLen, capacity - pendingLen);
+                if (format == JsonStreamFormat::Lines) {
+                    pending[pendingLen++] = '\n';
+                }
+                break;
+            }
+
+            case Stage::Close:
+                if (format == JsonStreamFormat::Array) {
+                    pending[pendingLen++] = ']';
+                }
+                stage = Stage::Done;
+                break;
+
+            case Stage::Done:
+                return written;
+        }
+    }
+
+    return written;
+}
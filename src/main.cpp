@@ -1,78 +1,113 @@
 #include <Arduino.h>
 #include <SPI.h>
+#include <esp_system.h>
 #include "config.h"
 #include "storage.h"
 #include "rfid.h"
 #include "display.h"
 #include "webserver.h"
+#include "selftest.h"
+#include "timer_service.h"
+#include "time_source.h"
 
 // Separate SPI-Busse für das Waveshare E-Paper ESP32 Driver Board
 SPIClass hspi(HSPI);  // Display (GPIO 13, 14)
 SPIClass vspi(VSPI);  // RFID (GPIO 18, 19, 23)
 
 // State Management
-String currentCardUID = "";
-Countdown* currentCountdown = nullptr;
-unsigned long lastCardCheck = 0;
-unsigned long lastMidnightCheck = 0;  // Timestamp der letzten Mitternachts-Prüfung
+CardUid currentCardUID;  // Leer = keine Karte aufgelegt
+// Karte des angezeigten Countdowns (leer = keiner). Der Countdown selbst wird
+// bei jeder Verwendung als Kopie aus dem Storage gelesen, da der Web-Task
+// die Liste jederzeit ändern kann.
+CardUid displayedCardUID;
 int lastUpdateDay = -1;  // Speichert den Tag der letzten Display-Aktualisierung
 bool displayNeedsUpdate = true;
+bool countdownWaitsForTime = false;  // Karte erkannt, aber noch keine gültige Uhrzeit
+uint32_t lastPanelRefreshCount = 0;  // Für display-refreshed Events
+
+const uint32_t NETWORK_POLL_INTERVAL = 100;  // ms, loop()-Takt nur während des WiFi-Verbindungsaufbaus
+
+// Boot-Ablauf: setup() macht nur Storage, RFID und Display bereit (Karten
+// werden ab dem Start des RFID-Tasks bedient). WiFi bzw. AP-Fallback und NTP
+// laufen im Hintergrund weiter und werden in loop() über serviceBoot()
+// weitergeschaltet. Jede Phase erscheint mit ihrer Dauer im Boot-Log.
+enum class BootPhase : uint8_t {
+    Network,    // WiFi-Verbindung oder AP-Fallback
+    Time,       // SNTP läuft, noch nicht synchronisiert
+    Done
+};
+BootPhase bootPhase = BootPhase::Network;
+unsigned long bootPhaseStart = 0;
+
+// Überlebt Software-Neustarts (nicht aber einen Stromausfall): der zuletzt
+// angezeigte Countdown. Das E-Paper behält sein Bild, nach einem Neustart
+// wird es daher nicht mit dem Willkommensbildschirm übermalt.
+#define RETAINED_DISPLAY_MAGIC 0x52455444
+struct RetainedDisplay {
+    uint32_t magic;
+    uint8_t uidLength;
+    uint8_t uid[CardUid::MAX_LENGTH];
+    int8_t day;             // tm_mday der Anzeige (-1 = unbekannt)
+};
+RTC_NOINIT_ATTR RetainedDisplay retainedDisplay;
+
+// Dauer der Boot-Phase seit der letzten Markierung ausgeben
+void logBootPhase(const char* name) {
+    unsigned long now = millis();
+    Serial.printf("[Boot] %-8s %6lu ms  (seit Start %lu ms)\n", name, now - bootPhaseStart, now);
+    bootPhaseStart = now;
+}
 
-const unsigned long CARD_CHECK_INTERVAL = 1000;    // Prüfe alle 1 Sekunde auf Karte
-const unsigned long MIDNIGHT_CHECK_INTERVAL = 60000; // Prüfe alle 60 Sekunden auf Mitternacht
-
-// Hilfsfunktion: Prüfe und aktualisiere wiederkehrende Events
-// Gibt die neuen daysRemaining zurück (oder die alten wenn kein Update nötig war)
-int checkAndUpdateRecurringEvent(Countdown* countdown, int daysRemaining) {
-    if (countdown == nullptr) return daysRemaining;
-
-    // Prüfe ob Event vorbei ist UND wiederkehrend ist
-    if (daysRemaining < 0 && countdown->recurring && countdown->recurringInterval == "yearly") {
-        Serial.println("🔄 Wiederkehrendes Ereignis erkannt - wechsle zu nächstem Jahr!");
-
-        // Parse aktuelles Datum (Format: YYYY-MM-DD)
-        int year, month, day;
-        if (sscanf(countdown->targetDate.c_str(), "%d-%d-%d", &year, &month, &day) == 3) {
-            // Erhöhe Jahr um 1
-            year++;
-
-            // Erstelle neues Datum
-            char newDate[11];
-            snprintf(newDate, sizeof(newDate), "%04d-%02d-%02d", year, month, day);
-
-            Serial.print("   Altes Datum: ");
-            Serial.println(countdown->targetDate);
-            Serial.print("   Neues Datum: ");
-            Serial.println(newDate);
-
-            // Aktualisiere Datum
-            countdown->targetDate = String(newDate);
-
-            // Speichere Änderung
-            if (storage.updateCountdown(countdown->uid, *countdown)) {
-                Serial.println("   ✓ Countdown erfolgreich aktualisiert");
-
-                // Berechne neue Tage und gib sie zurück
-                int newDaysRemaining = displayManager.calculateDaysRemaining(countdown->targetDate);
-                Serial.print("   Neue Tage verbleibend: ");
-                Serial.println(newDaysRemaining);
-                return newDaysRemaining;
-            } else {
-                Serial.println("   ✗ Fehler beim Speichern des aktualisierten Countdowns");
-            }
-        }
+bool isTimeValid() {
+    return timeSource.isValid();
+}
+
+void retainDisplay(const CardUid& uid) {
+    retainedDisplay.magic = RETAINED_DISPLAY_MAGIC;
+    retainedDisplay.uidLength = uid.length;
+    memcpy(retainedDisplay.uid, uid.bytes.data(), uid.length);
+    retainedDisplay.day = lastUpdateDay;
+}
+
+// Nach einem Software-Neustart den angezeigten Countdown übernehmen, damit
+// Mitternachts-Updates weiterlaufen. Liefert false nach einem Kaltstart.
+bool restoreDisplay() {
+    esp_reset_reason_t reason = esp_reset_reason();
+    if (reason == ESP_RST_POWERON || reason == ESP_RST_BROWNOUT ||
+        retainedDisplay.magic != RETAINED_DISPLAY_MAGIC ||
+        retainedDisplay.uidLength > CardUid::MAX_LENGTH) {
+        retainedDisplay.magic = 0;
+        return false;
     }
 
-    return daysRemaining;  // Keine Änderung nötig
+    if (retainedDisplay.uidLength > 0) {
+        CardUid uid = CardUid::fromBytes(retainedDisplay.uid, retainedDisplay.uidLength);
+        Countdown countdown;
+        if (storage.getCountdownByUID(uid, countdown)) {
+            displayedCardUID = uid;
+            lastUpdateDay = retainedDisplay.day;
+            displayNeedsUpdate = false;
+            Serial.print("Neustart: Display zeigt weiterhin ");
+            Serial.println(countdown.name);
+        }
+    }
+    return true;
 }
 
 void setup() {
     Serial.begin(115200);
-    delay(1000);
 
     Serial.println("\n\n=================================");
     Serial.println("   Countdown Display System");
     Serial.println("=================================\n");
+    logBootPhase("Start");
+
+    // Termine und Weckrufe für loop() (setup() läuft im selben Task)
+    timerService.begin();
+
+    // Zeitzone setzen, Uhr nach einem Neustart ohne Netzwerk wiederherstellen
+    timeSource.begin();
+    logBootPhase("Zeit");
 
     // Initialisiere Standard-SPI (VSPI) für RFID (GPIO 18, 19, 23)
     Serial.println("Initialisiere RFID SPI Bus (VSPI)...");
@@ -90,6 +125,14 @@ void setup() {
         Serial.println("FEHLER: Storage konnte nicht initialisiert werden!");
         while (1) delay(1000);
     }
+    logBootPhase("Storage");
+
+#ifdef UID_SELFTEST
+    runUidSelfTest();
+#endif
+#ifdef DATE_SELFTEST
+    runDateSelfTest();
+#endif
 
     // Initialisiere RFID
     Serial.println("Initialisiere RFID Reader...");
@@ -97,6 +140,8 @@ void setup() {
         Serial.println("FEHLER: RFID Reader konnte nicht initialisiert werden!");
         while (1) delay(1000);
     }
+    rfidReader.startTask();
+    logBootPhase("RFID");
 
     // Initialisiere Display
     Serial.println("Initialisiere E-Ink Display...");
@@ -105,164 +150,354 @@ void setup() {
         while (1) delay(1000);
     }
 
-    // Zeige Willkommensbildschirm
-    displayManager.showWelcomeScreen();
+    // Willkommensbildschirm nur nach einem Kaltstart
+    if (!restoreDisplay()) {
+        displayManager.showWelcomeScreen();
+    }
+    logBootPhase("Display");
 
-    // Initialisiere Webserver
+    // Webserver starten - WiFi verbindet sich im Hintergrund
     Serial.println("Initialisiere Webserver...");
     if (!webServer.begin()) {
         Serial.println("FEHLER: Webserver konnte nicht gestartet werden!");
     }
+    logBootPhase("Web");
+
+    Serial.println("\n=================================");
+    Serial.println("System bereit - Netzwerk startet im Hintergrund");
+    Serial.println("=================================\n");
+}
+
+// Hintergrund-Phasen des Boots weiterschalten (aus loop())
+void serviceBoot() {
+    switch (bootPhase) {
+        case BootPhase::Network:
+            if (!webServer.isNetworkReady()) {
+                return;
+            }
+            Serial.print("Webinterface: http://");
+            Serial.println(webServer.getIPAddress());
+
+            if (webServer.isAPMode()) {
+                // Ohne Internet kein NTP
+                logBootPhase("AP");
+                bootPhase = BootPhase::Done;
+                return;
+            }
+            logBootPhase("WiFi");
+
+            // SNTP läuft ab hier selbstständig im lwIP-Task, Auswertung und
+            // Backoff über timeSource (TIMER_TIME_CHANGED / TIMER_TIME_SOURCE)
+            timeSource.startSync();
+            bootPhase = BootPhase::Time;
+            return;
+
+        case BootPhase::Time:
+            // Die Anzeige korrigiert handleDayChange() beim TIMER_TIME_CHANGED
+            if (!timeSource.isSynced()) {
+                return;
+            }
+            logBootPhase("NTP");
+            bootPhase = BootPhase::Done;
+            return;
+
+        case BootPhase::Done:
+            return;
+    }
+}
+
+// Angezeigten Countdown aus dem Storage lesen. Wurde er inzwischen gelöscht
+// oder deaktiviert, wird die Anzeige zurückgesetzt.
+bool lookupDisplayedCountdown(Countdown& countdown) {
+    if (displayedCardUID.isEmpty()) {
+        return false;
+    }
+    if (storage.getCountdownByUID(displayedCardUID, countdown)) {
+        return true;
+    }
 
-    // Konfiguriere Zeit (NTP)
-    configTime(3600, 3600, "pool.ntp.org", "time.nist.gov"); // MEZ + Sommerzeit
-    Serial.println("Warte auf NTP Zeit-Synchronisation...");
+    Serial.println("Angezeigter Countdown wurde gelöscht oder deaktiviert");
+    displayedCardUID = CardUid();
+    countdownWaitsForTime = false;
+    displayNeedsUpdate = true;
+    timerService.cancel(TIMER_COUNTDOWN_CLOCK);
+    displayManager.showNoCardScreen();
+    retainDisplay(CardUid());
+    return false;
+}
 
-    // Warte auf Zeit-Sync (max 10 Sekunden)
-    int ntpWait = 0;
-    while (time(nullptr) < 100000 && ntpWait < 20) {
-        delay(500);
-        Serial.print(".");
-        ntpWait++;
+// Termin für den Stunden-Countdown stellen: 24 Stunden vor dem Ereignis, dann
+// im Raster von CLOCK_UPDATE_MINUTES (rückwärts vom Ereignis gerechnet, die
+// Anzeige springt also auf volle Vielfache), zuletzt zum Ereignis selbst
+static_assert(CLOCK_UPDATE_MINUTES >= 1 && CLOCK_UPDATE_MINUTES <= 60, "CLOCK_UPDATE_MINUTES: 1-60");
+
+void scheduleCountdownClock() {
+    time_t target = 0;
+    Countdown countdown;
+    if (!displayNeedsUpdate && isTimeValid() && lookupDisplayedCountdown(countdown)) {
+        target = displayManager.calculateTargetTime(countdown);
+    }
+    time_t remaining = target - time(nullptr);
+    if (target == 0 || remaining <= 0) {
+        timerService.cancel(TIMER_COUNTDOWN_CLOCK);
+        return;
     }
-    Serial.println();
 
-    if (time(nullptr) < 100000) {
-        Serial.println("WARNUNG: NTP Zeit-Synchronisation fehlgeschlagen!");
+    const time_t step = CLOCK_UPDATE_MINUTES * 60;
+    if (remaining > 24 * 3600) {
+        timerService.scheduleAt(TIMER_COUNTDOWN_CLOCK, target - 24 * 3600);
     } else {
-        time_t now = time(nullptr);
-        Serial.print("Aktuelle Zeit: ");
-        Serial.println(ctime(&now));
+        timerService.scheduleAt(TIMER_COUNTDOWN_CLOCK, target - ((remaining - 1) / step) * step);
     }
+}
 
-    Serial.println("\n=================================");
-    Serial.println("System bereit!");
-    Serial.println("=================================\n");
-    Serial.print("Webinterface: http://");
-    Serial.println(webServer.getIPAddress());
-    Serial.println();
+// Stunden-Countdown aktualisieren bzw. nach dem Ereignis zur Tagesanzeige zurück.
+// Nach einer Zeitänderung (timeChanged) nur das Verlassen des Zeitfensters
+// zeichnen, sonst bleibt die Anzeige bis zum nächsten Rastertermin stehen.
+void handleCountdownClock(bool timeChanged) {
+    Countdown countdown;
+    if (displayNeedsUpdate || !isTimeValid() || !lookupDisplayedCountdown(countdown)) {
+        return;
+    }
+    int daysRemaining = displayManager.calculateDaysRemaining(countdown);
+    if (daysRemaining == -9999) {
+        return;
+    }
+
+    int minutesRemaining = displayManager.calculateMinutesRemaining(countdown);
+    if (minutesRemaining >= 0) {
+        if (timeChanged) {
+            return;
+        }
+        displayManager.updateTimeRemaining(countdown, daysRemaining, minutesRemaining);
+    } else {
+        displayManager.updateDaysRemaining(countdown, daysRemaining);
+    }
 }
 
-void loop() {
-    unsigned long currentMillis = millis();
+// Countdown vollständig anzeigen (nur mit gültiger Uhrzeit)
+void showDisplayedCountdown(const Countdown& countdown) {
+    countdownWaitsForTime = false;
 
-    // Prüfe regelmäßig auf neue RFID Karte
-    if (currentMillis - lastCardCheck >= CARD_CHECK_INTERVAL) {
-        lastCardCheck = currentMillis;
+    int daysRemaining = displayManager.calculateDaysRemaining(countdown);
+    Serial.print("DEBUG: Berechnete Tage: ");
+    Serial.println(daysRemaining);
 
-        String uid = rfidReader.readCardUID();
+    if (daysRemaining == -9999) {
+        displayManager.showError("Ungültiges Datum");
+    } else {
+        Serial.print("Zeige Countdown: ");
+        Serial.print(countdown.name);
+        Serial.print(" - Tage verbleibend: ");
+        Serial.println(daysRemaining);
 
-        // Wenn keine Karte erkannt wurde, UID zurücksetzen
-        if (uid.length() == 0) {
-            if (currentCardUID.length() > 0) {
-                Serial.println("Karte entfernt - Countdown bleibt auf Display");
-                currentCardUID = "";
-                // currentCountdown NICHT auf nullptr setzen - bleibt auf Display!
-            }
+        // In den letzten 24 Stunden (Countdown mit Uhrzeit): HH:MM
+        displayManager.showCountdown(countdown, daysRemaining,
+                                     displayManager.calculateMinutesRemaining(countdown));
+
+        // Speichere aktuellen Tag für Mitternachts-Check
+        time_t now = time(nullptr);
+        struct tm timeinfo;
+        localtime_r(&now, &timeinfo);
+        lastUpdateDay = timeinfo.tm_mday;
+        retainDisplay(displayedCardUID);
+    }
+
+    displayNeedsUpdate = false;
+    scheduleCountdownClock();
+}
+
+// Neue Karte aus dem RFID-Task: passenden Countdown anzeigen
+void handleCardArrived(const CardEvent& event) {
+    uint32_t queuedUs = micros() - event.timestamp;
+    char uid[CardUid::HEX_SIZE];
+    event.uid.toHex(uid);
+
+    currentCardUID = event.uid;
+    Serial.print("Neue Karte erkannt: ");
+    Serial.println(uid);
+
+    // Suche entsprechenden Countdown
+    Countdown countdown;
+    if (storage.getCountdownByUID(event.uid, countdown)) {
+        displayedCardUID = event.uid;
+        Serial.print("Countdown gefunden: ");
+        Serial.println(countdown.name);
+
+        // SOFORT Display aktualisieren bei neuer Karte
+        Serial.print("DEBUG: Gespeichertes Datum: ");
+        Serial.println(countdown.targetDate);
+        Serial.print("DEBUG: Recurring: ");
+        Serial.print(countdown.recurring ? "JA" : "NEIN");
+        Serial.print(", Interval: ");
+        Serial.println(countdown.recurringInterval);
+
+        if (isTimeValid()) {
+            showDisplayedCountdown(countdown);
+        } else {
+            // Ohne Uhrzeit keine Tageszahl - angezeigt wird, sobald die Zeit
+            // gültig ist (TIMER_TIME_CHANGED)
+            Serial.println("Keine gültige Uhrzeit - Anzeige folgt nach der Zeit-Synchronisation");
+            countdownWaitsForTime = true;
         }
-        // Wenn eine neue Karte erkannt wurde
-        else if (uid != currentCardUID) {
-            currentCardUID = uid;
-            Serial.print("Neue Karte erkannt: ");
-            Serial.println(uid);
-
-            // Suche entsprechenden Countdown
-            currentCountdown = storage.getCountdownByUID(uid);
-
-            if (currentCountdown != nullptr) {
-                Serial.print("Countdown gefunden: ");
-                Serial.println(currentCountdown->name);
-
-                // SOFORT Display aktualisieren bei neuer Karte
-                Serial.print("DEBUG: Gespeichertes Datum: ");
-                Serial.println(currentCountdown->targetDate);
-                Serial.print("DEBUG: Recurring: ");
-                Serial.print(currentCountdown->recurring ? "JA" : "NEIN");
-                Serial.print(", Interval: ");
-                Serial.println(currentCountdown->recurringInterval);
-
-                int daysRemaining = displayManager.calculateDaysRemaining(currentCountdown->targetDate);
-                Serial.print("DEBUG: Berechnete Tage: ");
-                Serial.println(daysRemaining);
-
-                // Prüfe ob wiederkehrendes Event aktualisiert werden muss (BEVOR Display angezeigt wird)
-                daysRemaining = checkAndUpdateRecurringEvent(currentCountdown, daysRemaining);
-
-                if (daysRemaining == -9999) {
-                    displayManager.showError("Ungültiges Datum");
-                } else {
-                    Serial.print("Zeige Countdown: ");
-                    Serial.print(currentCountdown->name);
-                    Serial.print(" - Tage verbleibend: ");
-                    Serial.println(daysRemaining);
-
-                    displayManager.showCountdown(*currentCountdown, daysRemaining);
-
-                    // Speichere aktuellen Tag für Mitternachts-Check
-                    time_t now = time(nullptr);
-                    struct tm* timeinfo = localtime(&now);
-                    lastUpdateDay = timeinfo->tm_mday;
-                }
-
-                displayNeedsUpdate = false;
-            } else {
-                Serial.println("Keine Konfiguration für diese Karte gefunden");
-                displayManager.showNoCardScreen();
-                displayNeedsUpdate = false;
+    } else {
+        Serial.println("Keine Konfiguration für diese Karte gefunden");
+        displayedCardUID = CardUid();
+        displayManager.showNoCardScreen();
+        retainDisplay(CardUid());
+        countdownWaitsForTime = false;
+        displayNeedsUpdate = false;
+    }
+
+    // Latenz: Erkennung im RFID-Task -> Abholung in loop() -> Anzeige gestartet
+    Serial.printf("Latenz: Warteschlange %lu ms, bis Anzeige %lu ms\n",
+                  (unsigned long)(queuedUs / 1000), (unsigned long)((micros() - event.timestamp) / 1000));
+}
+
+// Termine für Tageswechsel und Nacht-Slot (neu) stellen: nach dem Stellen der
+// Uhr, einer Zeitzonenänderung und nachdem ein Termin ausgeführt wurde
+void scheduleDayTimers() {
+    if (!isTimeValid()) {
+        return;
+    }
+    time_t now = time(nullptr);
+    timerService.scheduleAt(TIMER_MIDNIGHT, nextLocalTime(now, 0, 0));
+#if FULL_REFRESH_HOUR >= 0
+    timerService.scheduleAt(TIMER_FULL_REFRESH, nextLocalTime(now, FULL_REFRESH_HOUR, 0));
+#endif
+}
+
+// Mitternachts-Update: nur die Tageszahl neu anzeigen
+void handleDayChange() {
+    Countdown countdown;
+    if (displayNeedsUpdate || !isTimeValid() || !lookupDisplayedCountdown(countdown)) {
+        return;
+    }
+
+    time_t now = time(nullptr);
+    struct tm timeinfo;
+    localtime_r(&now, &timeinfo);
+    int currentDay = timeinfo.tm_mday;
+
+    // lastUpdateDay == -1 (Tag der Anzeige unbekannt): einmal aktualisieren
+    if (currentDay == lastUpdateDay) {
+        return;
+    }
+    lastUpdateDay = currentDay;
+    retainedDisplay.day = currentDay;
+
+    int daysRemaining = displayManager.calculateDaysRemaining(countdown);
+    if (daysRemaining == -9999) {
+        return;
+    }
+
+    // Im Stunden-Countdown ist keine Tageszahl zu sehen (siehe handleCountdownClock())
+    if (displayManager.calculateMinutesRemaining(countdown) >= 0) {
+        return;
+    }
+
+    Serial.println("🌙 Mitternachts-Update: Neuer Tag erkannt!");
+    Serial.print("   Datum: ");
+    Serial.print(timeinfo.tm_mday);
+    Serial.print(".");
+    Serial.print(timeinfo.tm_mon + 1);
+    Serial.print(".");
+    Serial.println(timeinfo.tm_year + 1900);
+    Serial.print("   Aktualisiere Countdown: ");
+    Serial.println(countdown.name);
+
+    // Nur Tageszahl per Partial Refresh aktualisieren (bei geändertem
+    // Datum, z.B. nächstes Auftreten eines wiederkehrenden Ereignisses,
+    // automatisch Full Refresh)
+    displayManager.updateDaysRemaining(countdown, daysRemaining);
+}
+
+// Konfiguration im Webinterface geändert: angezeigten Countdown neu lesen
+// und bei geänderten Angaben (Name, Datum, Bild ...) neu zeichnen
+void handleConfigChanged() {
+    Countdown countdown;
+    if (!lookupDisplayedCountdown(countdown)) {
+        return;
+    }
+    if (displayNeedsUpdate || countdownWaitsForTime || !isTimeValid()) {
+        return;
+    }
+    if (!displayManager.isShowing(countdown)) {
+        Serial.println("Angezeigter Countdown wurde geändert - zeichne neu");
+        showDisplayedCountdown(countdown);
+    }
+}
+
+void loop() {
+    // Schlafen bis RFID, Display, WiFi oder ein Termin etwas melden. Nur
+    // während des WiFi-Verbindungsaufbaus zusätzlich regelmäßig (Timeout).
+    uint32_t due = timerService.waitForEvents(webServer.isNetworkReady() ? portMAX_DELAY
+                                                                         : NETWORK_POLL_INTERVAL);
+
+    // Ereignisse des RFID-Tasks abarbeiten (auch die während eines Refreshs)
+    CardEvent event;
+    while (rfidReader.pollEvent(event)) {
+        webServer.publishCardEvent(event);
+
+        if (event.type == CardEvent::Type::Removed) {
+            if (!currentCardUID.isEmpty()) {
+                Serial.printf("Karte entfernt nach %lu ms - Countdown bleibt auf Display\n",
+                              (unsigned long)event.dwellMs);
+                currentCardUID = CardUid();
+                // displayedCardUID NICHT zurücksetzen - bleibt auf Display!
             }
+        } else {
+            handleCardArrived(event);
         }
     }
 
-    // Mitternachts-Update: Prüfe ob neuer Tag begonnen hat
-    if (currentCountdown != nullptr && !displayNeedsUpdate) {
-        // Prüfe alle 60 Sekunden auf Tageswechsel
-        if (currentMillis - lastMidnightCheck >= MIDNIGHT_CHECK_INTERVAL) {
-            lastMidnightCheck = currentMillis;  // Update nur Check-Zeit, nicht Display-Zeit!
-
-            // Hole aktuelle Zeit
-            time_t now = time(nullptr);
-            if (now > 100000) {  // Prüfe ob Zeit synchronisiert ist
-                struct tm* timeinfo = localtime(&now);
-                int currentDay = timeinfo->tm_mday;
-
-                // Debug-Ausgabe jede Minute
-                Serial.print("Mitternachts-Check: Aktueller Tag = ");
-                Serial.print(currentDay);
-                Serial.print(", Letzter Update Tag = ");
-                Serial.println(lastUpdateDay);
-
-                // Wenn der Tag sich geändert hat (nach Mitternacht)
-                if (lastUpdateDay != -1 && currentDay != lastUpdateDay) {
-                    lastUpdateDay = currentDay;
-
-                    int daysRemaining = displayManager.calculateDaysRemaining(currentCountdown->targetDate);
-
-                    if (daysRemaining != -9999) {
-                        Serial.println("🌙 Mitternachts-Update: Neuer Tag erkannt!");
-                        Serial.print("   Datum: ");
-                        Serial.print(timeinfo->tm_mday);
-                        Serial.print(".");
-                        Serial.print(timeinfo->tm_mon + 1);
-                        Serial.print(".");
-                        Serial.println(timeinfo->tm_year + 1900);
-                        Serial.print("   Aktualisiere Countdown: ");
-                        Serial.println(currentCountdown->name);
-
-                        // Prüfe ob wiederkehrendes Event aktualisiert werden muss
-                        daysRemaining = checkAndUpdateRecurringEvent(currentCountdown, daysRemaining);
-
-                        displayManager.showCountdown(*currentCountdown, daysRemaining);
-                    }
-                }
-            } else {
-                Serial.println("⚠️  Zeit noch nicht synchronisiert!");
-            }
+    // Uhr gestellt, Zeitzone geändert oder Tageswechsel: Tageszahl prüfen
+    // (genau zum Termin, bei einer Zeitänderung auch sofort)
+    if (due & TIMER_TIME_CHANGED) {
+        timeSource.handleTimeChanged();
+        Countdown countdown;
+        if (countdownWaitsForTime && isTimeValid() && lookupDisplayedCountdown(countdown)) {
+            showDisplayedCountdown(countdown);
         }
     }
+    if (due & TIMER_CONFIG_CHANGED) {
+        handleConfigChanged();
+    }
+    if (due & (TIMER_DUE(TIMER_MIDNIGHT) | TIMER_TIME_CHANGED)) {
+        handleDayChange();
+    }
 
-    // Webserver läuft asynchron
-    webServer.handle();
+    // Stunden-Countdown in den letzten 24 Stunden vor einem Ereignis mit Uhrzeit
+    if (due & TIMER_DUE(TIMER_COUNTDOWN_CLOCK)) {
+        handleCountdownClock(false);
+    } else if (due & TIMER_TIME_CHANGED) {
+        handleCountdownClock(true);
+    }
+
+    // Zeit sichern, SNTP-Synchronisation überwachen (Backoff)
+    if (due & TIMER_DUE(TIMER_TIME_SOURCE)) {
+        timeSource.service();
+    }
+
+    // Eingeplanten Full Refresh (Ghosting-Schutz) im Nacht-Slot ausführen
+    if ((due & TIMER_DUE(TIMER_FULL_REFRESH)) && displayManager.isFullRefreshPending()) {
+        displayManager.performScheduledFullRefresh();
+    }
 
-    // Kleine Pause
-    delay(10);
+    if (due) {
+        scheduleDayTimers();
+        scheduleCountdownClock();
+    }
+
+    // Abgeschlossene Panel-Refreshes an die Web-Clients melden
+    uint32_t refreshCount = displayManager.getPanelRefreshCount();
+    if (refreshCount != lastPanelRefreshCount) {
+        lastPanelRefreshCount = refreshCount;
+        webServer.publishDisplayRefreshed(displayManager.wasLastRefreshPartial(),
+                                          displayManager.getLastRefreshDuration(), refreshCount);
+    }
+
+    // WiFi-Verbindungsaufbau und Boot-Phasen im Hintergrund
+    webServer.handle();
+    serviceBoot();
 }
@@ -0,0 +1,58 @@
+#include "ndjson.h"
+
+NdjsonLineReader::NdjsonLineReader() : length(0), overflow(false), lineNumber(0) {
+}
+
+void NdjsonLineReader::feed(const uint8_t* data, size_t len) {
+    while (len > 0) {
+        const uint8_t* newline = (const uint8_t*)memchr(data, '\n', len);
+        size_t segment = newline ? (size_t)(newline - data) : len;
+
+        // Platz für den Nullterminator freihalten
+        if (!overflow) {
+            if (length + segment < sizeof(line)) {
+                memcpy(line + length, data, segment);
+                length += segment;
+            } else {
+                overflow = true;
+            }
+        }
+
+        if (!newline) {
+            return;
+        }
+        emit();
+        data += segment + 1;
+        len -= segment + 1;
+    }
+}
+
+void NdjsonLineReader::finish() {
+    if (length > 0 || overflow) {
+        emit();
+    }
+}
+
+void NdjsonLineReader::emit() {
+    lineNumber++;
+
+    // "\r\n" Zeilenenden und umgebende Leerzeichen entfernen
+    size_t start = 0;
+    while (start < length && isspace((uint8_t)line[start])) {
+        start++;
+    }
+    while (length > start && isspace((uint8_t)line[length - 1])) {
+        length--;
+    }
+
+    if (overflow) {
+        line[0] = '\0';
+        onLine(lineNumber, line, 0, true);
+    } else if (length > start) {
+        line[length] = '\0';
+        onLine(lineNumber, line + start, length - start, false);
+    }
+
+    length = 0;
+    overflow = false;
+}
@@ -0,0 +1,54 @@
+#include "recurrence.h"
+
+Recurrence parseRecurrence(bool recurring, const String& interval) {
+    if (!recurring) {
+        return Recurrence::None;
+    }
+    if (interval == "yearly") {
+        return Recurrence::Yearly;
+    }
+    if (interval == "monthly") {
+        return Recurrence::Monthly;
+    }
+    if (interval == "weekly") {
+        return Recurrence::Weekly;
+    }
+    return Recurrence::None;
+}
+
+// Ankertag im angegebenen Monat, gekürzt auf die Monatslänge
+static int32_t clampedDay(int32_t year, uint8_t month, uint8_t day) {
+    uint8_t length = daysInMonth(year, month);
+    return daysFromCivil(year, month, day > length ? length : day);
+}
+
+int32_t nextOccurrence(int32_t anchorDay, Recurrence rule, int32_t today) {
+    if (anchorDay == INVALID_EPOCH_DAY || rule == Recurrence::None || anchorDay >= today) {
+        return anchorDay;
+    }
+
+    if (rule == Recurrence::Weekly) {
+        return anchorDay + (today - anchorDay + 6) / 7 * 7;
+    }
+
+    CivilDate anchor = civilFromDays(anchorDay);
+    CivilDate now = civilFromDays(today);
+    int32_t year = now.year;
+
+    if (rule == Recurrence::Yearly) {
+        int32_t candidate = clampedDay(year, anchor.month, anchor.day);
+        return candidate >= today ? candidate : clampedDay(year + 1, anchor.month, anchor.day);
+    }
+
+    // Monatlich
+    uint8_t month = now.month;
+    int32_t candidate = clampedDay(year, month, anchor.day);
+    if (candidate >= today) {
+        return candidate;
+    }
+    if (++month > 12) {
+        month = 1;
+        year++;
+    }
+    return clampedDay(year, month, anchor.day);
+}
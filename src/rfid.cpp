@@ -1,19 +1,29 @@
 #include "rfid.h"
+#include "timer_service.h"
 #include "config.h"
 
 RFIDReader rfidReader;
 
-RFIDReader::RFIDReader() : mfrc522(RFID_SS_PIN, RFID_RST_PIN), lastReadTime(0) {
+RFIDReader::RFIDReader()
+    : mfrc522(RFID_SS_PIN, RFID_RST_PIN), task(nullptr), irqMode(false), readerLock(nullptr), version(0),
+      presence(Presence::Absent), detectedAt(0), arrivedAt(0), lastSeen(0),
+      lastLock(portMUX_INITIALIZER_UNLOCKED), lastReadTime(0), stats{} {
 }
 
 bool RFIDReader::begin() {
+    readerLock = xSemaphoreCreateMutex();
+    if (!readerLock) {
+        Serial.println("RFID-Sperre konnte nicht angelegt werden!");
+        return false;
+    }
+
     // SPI Bus ist bereits in main.cpp initialisiert
     // Initialisiere nur das RFID Modul
     mfrc522.PCD_Init();
     delay(100);
 
     // Prüfe ob RFID Modul antwortet
-    byte version = mfrc522.PCD_ReadRegister(mfrc522.VersionReg);
+    version = readVersion();
     if (version == 0x00 || version == 0xFF) {
         Serial.println("RFID Modul nicht gefunden!");
         return false;
@@ -21,52 +31,269 @@ bool RFIDReader::begin() {
 
     Serial.print("RFID RC522 gefunden, Version: 0x");
     Serial.println(version, HEX);
+
+    // Register werden nur hier einmal gesetzt, nicht bei jeder Abfrage.
+    // Empfangs-Timeout verkürzen (PCD_Init: 25 µs pro Timer-Tick, 25 ms):
+    // ATQA und SAK kommen nach weniger als 1 ms, ohne Karte fragt die
+    // Bibliothek sonst bei jeder Abfrage 25 ms lang ComIrqReg ab.
+    uint16_t reload = RFID_RX_TIMEOUT_US / 25;
+    mfrc522.PCD_WriteRegister(mfrc522.TReloadRegH, reload >> 8);
+    mfrc522.PCD_WriteRegister(mfrc522.TReloadRegL, reload & 0xFF);
     return true;
 }
 
-bool RFIDReader::cardPresent() {
-    // Prüfe ob eine neue Karte vorhanden ist
-    if (!mfrc522.PICC_IsNewCardPresent()) {
-        return false;
+bool RFIDReader::startTask() {
+    if (task) {
+        return true;
     }
 
-    // Versuche die Karte zu lesen
-    if (!mfrc522.PICC_ReadCardSerial()) {
+#if RFID_IRQ_PIN >= 0
+    // Empfangs-Interrupt des RC522 auf den IRQ-Pin legen (aktiv low)
+    pinMode(RFID_IRQ_PIN, INPUT_PULLUP);
+    mfrc522.PCD_WriteRegister(mfrc522.ComIEnReg, 0xA0);
+    attachInterruptArg(digitalPinToInterrupt(RFID_IRQ_PIN), irqHandler, this, FALLING);
+    irqMode = true;
+#endif
+
+    if (xTaskCreatePinnedToCore(taskEntry, "rfid", RFID_TASK_STACK, this,
+                                RFID_TASK_PRIORITY, &task, RFID_TASK_CORE) != pdPASS) {
+        Serial.println("RFID-Task konnte nicht gestartet werden!");
+        task = nullptr;
         return false;
     }
 
+    Serial.printf("RFID-Task gestartet (%s, %u ms)\n", irqMode ? "IRQ" : "Polling",
+                  (unsigned)RFID_POLL_INTERVAL_MS);
     return true;
 }
 
-String RFIDReader::readCardUID() {
-    if (!cardPresent()) {
-        return "";
+void RFIDReader::taskEntry(void* param) {
+    static_cast<RFIDReader*>(param)->taskLoop();
+}
+
+void IRAM_ATTR RFIDReader::irqHandler(void* param) {
+    RFIDReader* reader = static_cast<RFIDReader*>(param);
+    if (!reader->task) {
+        return;
     }
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(reader->task, &woken);
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
 
-    String uid = uidToString(mfrc522.uid.uidByte, mfrc522.uid.size);
+void RFIDReader::taskLoop() {
+    const TickType_t interval = pdMS_TO_TICKS(RFID_POLL_INTERVAL_MS);
 
-    // Halt PICC
-    mfrc522.PICC_HaltA();
-    // Stop encryption on PCD
-    mfrc522.PCD_StopCrypto1();
+    for (;;) {
+        bool requested = false;
+        if (irqMode && presence == Presence::Absent) {
+            // REQA senden und schlafen, bis eine Karte antwortet. Ohne Antwort
+            // wird nach einem Intervall neu gesendet, ohne den Leser abzufragen.
+            lockReader();
+            armIrq();
+            unlockReader();
+            if (ulTaskNotifyTake(pdTRUE, interval) == 0) {
+                continue;
+            }
+            requested = true;
+        } else {
+            vTaskDelay(interval);
+        }
 
-    lastUID = uid;
-    lastReadTime = millis();
+        lockReader();
+        uint32_t start = micros();
+        if (requested) {
+            mfrc522.PCD_WriteRegister(mfrc522.ComIrqReg, 0x7F);
+        }
+        poll(requested);
+        uint32_t duration = micros() - start;
+        unlockReader();
+
+        portENTER_CRITICAL(&lastLock);
+        stats.polls++;
+        stats.spiTimeUs += duration;
+        if (duration > stats.spiMaxUs) {
+            stats.spiMaxUs = duration;
+        }
+        portEXIT_CRITICAL(&lastLock);
+    }
+}
+
+void RFIDReader::lockReader() {
+    if (xSemaphoreTake(readerLock, 0) == pdTRUE) {
+        return;
+    }
+    portENTER_CRITICAL(&lastLock);
+    stats.contention++;
+    portEXIT_CRITICAL(&lastLock);
+    xSemaphoreTake(readerLock, portMAX_DELAY);
+}
+
+void RFIDReader::unlockReader() {
+    xSemaphoreGive(readerLock);
+}
 
-    Serial.print("Karte gelesen: ");
-    Serial.println(uid);
+uint8_t RFIDReader::readVersion() {
+    lockReader();
+    uint8_t version = mfrc522.PCD_ReadRegister(mfrc522.VersionReg);
+    unlockReader();
+    return version;
+}
 
-    return uid;
+void RFIDReader::armIrq() {
+    mfrc522.PCD_WriteRegister(mfrc522.CommandReg, mfrc522.PCD_Idle);
+    mfrc522.PCD_WriteRegister(mfrc522.ComIrqReg, 0x7F);
+    mfrc522.PCD_WriteRegister(mfrc522.FIFOLevelReg, 0x80);
+    mfrc522.PCD_WriteRegister(mfrc522.FIFODataReg, mfrc522.PICC_CMD_REQA);
+    mfrc522.PCD_WriteRegister(mfrc522.CommandReg, mfrc522.PCD_Transceive);
+    mfrc522.PCD_WriteRegister(mfrc522.BitFramingReg, 0x87);
 }
 
-String RFIDReader::uidToString(byte* uid, byte size) {
-    String uidString = "";
-    for (byte i = 0; i < size; i++) {
-        if (uid[i] < 0x10) {
-            uidString += "0";
+void RFIDReader::poll(bool requested) {
+    uint32_t pollStart = micros();
+    unsigned long now = millis();
+
+    if (presence == Presence::Absent) {
+        // Nach einem IRQ hat die Karte das REQA bereits beantwortet
+        if (!requested && !requestCard(false)) {
+            return;
+        }
+        if (!selectCard()) {
+            return;
+        }
+        haltCard();
+        beginArrival(CardUid::fromBytes(mfrc522.uid.uidByte, mfrc522.uid.size), pollStart, now);
+        return;
+    }
+
+    // Karte liegt (vermutlich) noch auf: WUPA weckt sie aus dem HALT-Zustand,
+    // Anticollision/Select liefert ihre UID, danach sofort wieder schlafen
+    // legen. Nur so fällt eine innerhalb des Entprell-Fensters getauschte Karte auf.
+    if (requestCard(true)) {
+        lastSeen = now;
+        bool selected = selectCard();
+        haltCard();
+        CardUid uid = CardUid::fromBytes(mfrc522.uid.uidByte, mfrc522.uid.size);
+        if (selected && uid != presentUid) {
+            if (presence == Presence::Present) {
+                publish(CardEvent::Type::Removed, presentUid, pollStart, now - arrivedAt);
+            }
+            beginArrival(uid, pollStart, now);
+            return;
+        }
+    }
+
+    if (presence == Presence::Arriving) {
+        if (lastSeen != now) {
+            // Nur kurz im Feld (z.B. vorbeigezogen) - kein Ereignis
+            presence = Presence::Absent;
+        } else if (now - arrivedAt >= RFID_ARRIVE_DEBOUNCE_MS) {
+            confirmArrival();
         }
-        uidString += String(uid[i], HEX);
+        return;
+    }
+
+    // Aussetzer am Rand des Feldes erst nach dem Entprell-Fenster als Entfernen werten
+    if (now - lastSeen >= RFID_REMOVE_DEBOUNCE_MS) {
+        presence = Presence::Absent;
+        publish(CardEvent::Type::Removed, presentUid, pollStart, lastSeen - arrivedAt);
+    }
+}
+
+void RFIDReader::beginArrival(const CardUid& uid, uint32_t pollStart, unsigned long now) {
+    presentUid = uid;
+    detectedAt = pollStart;
+    arrivedAt = now;
+    lastSeen = now;
+    presence = Presence::Arriving;
+    if (RFID_ARRIVE_DEBOUNCE_MS == 0) {
+        confirmArrival();
+    }
+}
+
+void RFIDReader::confirmArrival() {
+    presence = Presence::Present;
+
+    portENTER_CRITICAL(&lastLock);
+    lastUid = presentUid;
+    lastReadTime = millis();
+    stats.reads++;
+    portEXIT_CRITICAL(&lastLock);
+
+    publish(CardEvent::Type::Arrived, presentUid, detectedAt, 0);
+}
+
+bool RFIDReader::requestCard(bool wakeup) {
+    // Direkt REQA/WUPA statt PICC_IsNewCardPresent(): das setzt vor jeder
+    // Abfrage Baudrate und Modulation neu, die sich seit PCD_Init nicht ändern
+    byte atqa[2];
+    byte size = sizeof(atqa);
+    MFRC522::StatusCode status = wakeup ? mfrc522.PICC_WakeupA(atqa, &size)
+                                        : mfrc522.PICC_RequestA(atqa, &size);
+    // Kollision = mehrere Karten im Feld, also ebenfalls anwesend
+    return status == MFRC522::STATUS_OK || status == MFRC522::STATUS_COLLISION;
+}
+
+bool RFIDReader::selectCard() {
+    return mfrc522.PICC_Select(&mfrc522.uid) == MFRC522::STATUS_OK && mfrc522.uid.size > 0;
+}
+
+void RFIDReader::haltCard() {
+    // HLTA wird nie beantwortet: nur senden statt wie PICC_HaltA() den ganzen
+    // Empfangs-Timeout abzuwarten. Die CRC des Frames ist konstant. Ohne
+    // Authentifizierung ist auch kein PCD_StopCrypto1() nötig.
+    static byte hlta[] = { MFRC522::PICC_CMD_HLTA, 0x00, 0x57, 0xCD };
+    mfrc522.PCD_WriteRegister(mfrc522.CommandReg, mfrc522.PCD_Idle);
+    mfrc522.PCD_WriteRegister(mfrc522.FIFOLevelReg, 0x80);
+    mfrc522.PCD_WriteRegister(mfrc522.FIFODataReg, sizeof(hlta), hlta);
+    mfrc522.PCD_WriteRegister(mfrc522.CommandReg, mfrc522.PCD_Transceive);
+    mfrc522.PCD_WriteRegister(mfrc522.BitFramingReg, 0x80);
+}
+
+void RFIDReader::publish(CardEvent::Type type, const CardUid& uid, uint32_t timestamp, uint32_t dwellMs) {
+    CardEvent event;
+    event.type = type;
+    event.uid = uid;
+    event.timestamp = timestamp;
+    event.dwellMs = dwellMs;
+    if (!events.push(event)) {
+        Serial.println("RFID: Ereignis-Puffer voll, Ereignis verworfen");
     }
-    uidString.toUpperCase();
-    return uidString;
+    timerService.wake();
+}
+
+String RFIDReader::getLastCardUID() {
+    portENTER_CRITICAL(&lastLock);
+    CardUid uid = lastUid;
+    portEXIT_CRITICAL(&lastLock);
+    return uidToString(uid);
+}
+
+unsigned long RFIDReader::getLastReadTime() {
+    portENTER_CRITICAL(&lastLock);
+    unsigned long time = lastReadTime;
+    portEXIT_CRITICAL(&lastLock);
+    return time;
+}
+
+uint32_t RFIDReader::getReadCount() {
+    portENTER_CRITICAL(&lastLock);
+    uint32_t count = stats.reads;
+    portEXIT_CRITICAL(&lastLock);
+    return count;
+}
+
+RfidStats RFIDReader::getStats() {
+    portENTER_CRITICAL(&lastLock);
+    RfidStats copy = stats;
+    portEXIT_CRITICAL(&lastLock);
+    return copy;
+}
+
+String RFIDReader::uidToString(const CardUid& uid) {
+    char hex[CardUid::HEX_SIZE];
+    uid.toHex(hex);
+    return String(hex);
 }
@@ -0,0 +1,214 @@
+#include "router.h"
+
+// Markierungen in request->_tempObject für abgelehnte Bodies (ohne Speicher).
+// Ansonsten steht dort die BodyArena des Requests. AsyncWebServerRequest gibt
+// _tempObject beim Löschen mit free() frei - deshalb wird der Eintrag immer
+// vorher über releaseBody() zurückgesetzt.
+static uint8_t bodyTooLarge;
+static uint8_t bodyNoArena;
+
+String RouteRequest::paramString() const {
+    String value;
+    value.concat(paramValue, paramLen);
+    return value;
+}
+
+Router::Router() : routes(nullptr), routeCount(0), slots(nullptr), mask(0), rejected(0) {
+}
+
+Router::~Router() {
+    free(slots);
+}
+
+uint32_t Router::routeKey(uint32_t method, const char* path, size_t len, bool wildcard) {
+    // FNV-1a über Methode, Pfad und Parameter-Markierung
+    uint32_t h = 2166136261u;
+    h = (h ^ method) * 16777619u;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ (uint8_t)path[i]) * 16777619u;
+    }
+    if (wildcard) {
+        h = (h ^ ':') * 16777619u;
+    }
+    return h;
+}
+
+size_t Router::prefixLength(const char* pattern, bool* wildcard) {
+    size_t len = strlen(pattern);
+    const char* lastSlash = strrchr(pattern, '/');
+    *wildcard = lastSlash && lastSlash[1] == ':';
+    return *wildcard ? (size_t)(lastSlash - pattern + 1) : len;
+}
+
+bool Router::begin(const Route* table, size_t count, size_t arenaCount, size_t arenaSize) {
+    if (!arenas.begin(arenaCount, arenaSize)) {
+        return false;
+    }
+
+    size_t size = 8;
+    while (size < count * 2) {
+        size <<= 1;
+    }
+
+    free(slots);
+    slots = (Slot*)malloc(size * sizeof(Slot));
+    if (!slots) {
+        return false;
+    }
+    mask = size - 1;
+    for (size_t i = 0; i < size; i++) {
+        slots[i].key = 0;
+        slots[i].route = -1;
+    }
+
+    routes = table;
+    routeCount = count;
+
+    for (size_t r = 0; r < count; r++) {
+        if (table[r].maxBody > arenaSize) {
+            Serial.printf("Route %s: maxBody größer als Arena (%u)\n", table[r].pattern, (unsigned)arenaSize);
+        }
+
+        bool wildcard;
+        size_t len = prefixLength(table[r].pattern, &wildcard);
+        uint32_t key = routeKey(table[r].method, table[r].pattern, len, wildcard);
+
+        uint32_t i = key & mask;
+        while (slots[i].route >= 0) {
+            i = (i + 1) & mask;
+        }
+        slots[i].key = key;
+        slots[i].route = r;
+    }
+
+    return true;
+}
+
+const Route* Router::lookup(uint32_t key, uint32_t method, const char* path, size_t len, bool wildcard) const {
+    for (uint32_t i = key & mask; slots[i].route >= 0; i = (i + 1) & mask) {
+        if (slots[i].key != key) {
+            continue;
+        }
+
+        // Hash-Kollisionen ausschließen
+        const Route& route = routes[slots[i].route];
+        bool routeWildcard;
+        if (route.method == method &&
+            prefixLength(route.pattern, &routeWildcard) == len &&
+            routeWildcard == wildcard &&
+            strncmp(route.pattern, path, len) == 0) {
+            return &route;
+        }
+    }
+    return nullptr;
+}
+
+const Route* Router::match(AsyncWebServerRequest* request, size_t* paramOffset) const {
+    if (!slots) {
+        return nullptr;
+    }
+
+    const String& url = request->url();
+    const char* path = url.c_str();
+    size_t len = url.length();
+    uint32_t method = request->method();
+
+    // 1. Fester Pfad
+    const Route* route = lookup(routeKey(method, path, len, false), method, path, len, false);
+    if (route) {
+        *paramOffset = len;
+        return route;
+    }
+
+    // 2. Letztes Segment als Parameter (darf nicht leer sein)
+    const char* lastSlash = strrchr(path, '/');
+    if (!lastSlash || lastSlash[1] == '\0') {
+        return nullptr;
+    }
+    size_t prefix = lastSlash - path + 1;
+    route = lookup(routeKey(method, path, prefix, true), method, path, prefix, true);
+    if (route) {
+        *paramOffset = prefix;
+    }
+    return route;
+}
+
+bool Router::canHandle(AsyncWebServerRequest* request) const {
+    size_t paramOffset;
+    return match(request, &paramOffset) != nullptr;
+}
+
+void Router::releaseBody(AsyncWebServerRequest* request) {
+    void* state = request->_tempObject;
+    if (state && state != &bodyTooLarge && state != &bodyNoArena) {
+        arenas.release((BodyArena*)state);
+    }
+    request->_tempObject = nullptr;
+}
+
+void Router::handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+    if (index == 0 && !request->_tempObject) {
+        size_t paramOffset;
+        const Route* route = match(request, &paramOffset);
+        size_t limit = route ? min(route->maxBody, arenas.getArenaSize()) : 0;
+
+        BodyArena* arena = nullptr;
+        if (total > limit) {
+            rejected++;
+            request->_tempObject = &bodyTooLarge;
+        } else if ((arena = arenas.acquire()) == nullptr) {
+            request->_tempObject = &bodyNoArena;
+        } else {
+            arena->length = total;
+            request->_tempObject = arena;
+        }
+
+        // Bricht der Client vorzeitig ab, wird handleRequest() nie aufgerufen
+        request->onDisconnect([this, request]() {
+            releaseBody(request);
+        });
+    }
+
+    void* state = request->_tempObject;
+    if (!state || state == &bodyTooLarge || state == &bodyNoArena) {
+        return;
+    }
+
+    BodyArena* arena = (BodyArena*)state;
+    if (index + len > arena->length) {
+        return;
+    }
+    memcpy(arena->data + index, data, len);
+    arena->received += len;
+}
+
+void Router::handleRequest(AsyncWebServerRequest* request) {
+    size_t paramOffset;
+    const Route* route = match(request, &paramOffset);
+    void* state = request->_tempObject;
+
+    if (!route) {
+        request->send(404, "application/json", "{\"success\":false,\"error\":\"Not Found\"}");
+    } else if (state == &bodyTooLarge) {
+        request->send(413, "application/json", "{\"success\":false,\"error\":\"Request zu groß\"}");
+    } else if (state == &bodyNoArena) {
+        request->send(503, "application/json", "{\"success\":false,\"error\":\"Server ausgelastet\"}");
+    } else {
+        BodyArena* arena = (BodyArena*)state;
+        if (route->maxBody > 0 && (!arena || arena->received != arena->length)) {
+            request->send(400, "application/json", "{\"success\":false,\"error\":\"Unvollständiger Request\"}");
+        } else {
+            RouteRequest context;
+            context.request = request;
+            context.body = arena ? arena->data : nullptr;
+            context.bodyLength = arena ? arena->length : 0;
+            context.paramValue = request->url().c_str() + paramOffset;
+            context.paramLen = request->url().length() - paramOffset;
+
+            route->handler(context);
+        }
+    }
+
+    // Handler sind synchron - die Arena wird sofort wieder frei
+    releaseBody(request);
+}
@@ -0,0 +1,161 @@
+#include "selftest.h"
+
+#ifdef UID_SELFTEST
+
+#include <atomic>
+#include "rfid.h"
+#include "storage.h"
+
+// Allokationszähler: malloc/calloc/realloc werden per Linker umgeleitet
+// (-Wl,--wrap=..., siehe platformio.ini). Gezählt wird nur im Task, der
+// gerade misst - Allokationen anderer Tasks verfälschen das Ergebnis nicht.
+static TaskHandle_t countingTask = nullptr;
+static std::atomic<uint32_t> allocations(0);
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+    if (countingTask && xTaskGetCurrentTaskHandle() == countingTask) {
+        allocations++;
+    }
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    if (countingTask && xTaskGetCurrentTaskHandle() == countingTask) {
+        allocations++;
+    }
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    if (countingTask && xTaskGetCurrentTaskHandle() == countingTask) {
+        allocations++;
+    }
+    return __real_realloc(ptr, size);
+}
+}
+
+bool runUidSelfTest() {
+    static const uint8_t raw[2][7] = {
+        { 0x04, 0xA1, 0xB2, 0xC3 },
+        { 0x04, 0x5E, 0x21, 0x9A, 0x6F, 0x61, 0x80 },
+    };
+    static const uint8_t rawSize[2] = { 4, 7 };
+    const uint32_t rounds = 1000;
+
+    SpscRing<CardEvent, 16> ring;
+    CardUid current;
+    char hex[CardUid::HEX_SIZE];
+    uint32_t changes = 0;
+    uint32_t hits = 0;
+
+    // Gleicher Ablauf wie RFID-Task -> loop(): UID aus den Rohdaten, Ereignis
+    // über den Ringpuffer, Vergleich mit der aktuellen Karte, Lookup, Log-Text
+    allocations = 0;
+    countingTask = xTaskGetCurrentTaskHandle();
+    for (uint32_t i = 0; i < rounds; i++) {
+        CardEvent event;
+        event.type = CardEvent::Type::Arrived;
+        event.uid = CardUid::fromBytes(raw[i & 1], rawSize[i & 1]);
+        event.timestamp = micros();
+        event.dwellMs = 0;
+        ring.push(event);
+
+        CardEvent received;
+        while (ring.pop(received)) {
+            if (received.uid != current) {
+                current = received.uid;
+                changes++;
+            }
+            if (storage.hasCountdown(received.uid)) {
+                hits++;
+            }
+            received.uid.toHex(hex);
+        }
+    }
+    countingTask = nullptr;
+    uint32_t counted = allocations;
+
+    // Hex-Darstellung und vorberechneter Hash müssen zusammenpassen
+    CardUid parsed;
+    bool roundTrip = CardUid::fromHex(hex, strlen(hex), parsed) &&
+                     parsed == current && parsed.hash() == current.hash();
+
+    bool ok = counted == 0 && roundTrip && changes == rounds;
+    Serial.printf("Selbsttest UID-Pfad: %u Durchläufe, %u Treffer, %u Allokationen, Hex %s -> %s\n",
+                  (unsigned)rounds, (unsigned)hits, (unsigned)counted, hex, ok ? "OK" : "FEHLER");
+    return ok;
+}
+
+#endif
+
+#ifdef DATE_SELFTEST
+
+#include "civil_date.h"
+
+bool runDateSelfTest() {
+    // Referenz: Kalender Tag für Tag weiterzählen
+    static const uint8_t monthDays[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    int year = 1970;
+    int month = 1;
+    int day = 1;
+    int weekday = 4;  // 1970-01-01 war ein Donnerstag
+    int32_t epochDay = 0;
+    uint32_t errors = 0;
+    char text[16];
+
+    while (year <= 2100) {
+        CivilDate civil = civilFromDays(epochDay);
+        snprintf(text, sizeof(text), "%04d-%02d-%02d", year, month, day);
+
+        bool ok = daysFromCivil(year, month, day) == epochDay &&
+                  civil.year == year && civil.month == month && civil.day == day &&
+                  weekdayFromDays(epochDay) == weekday &&
+                  parseIsoDate(text, strlen(text)) == epochDay;
+
+        // gmtime_r() als zweite Referenz, solange die Sekunden in time_t
+        // passen (32 Bit: bis 2038)
+        if (epochDay <= TIME_T_MAX_EPOCH_DAY) {
+            time_t seconds = (time_t)epochDay * 86400;
+            struct tm utc;
+            gmtime_r(&seconds, &utc);
+            ok = ok && utc.tm_year + 1900 == year && utc.tm_mon + 1 == month && utc.tm_mday == day;
+        }
+        if (!ok && errors++ < 5) {
+            Serial.printf("Selbsttest Datum: Abweichung bei %s (Tag %ld)\n", text, (long)epochDay);
+        }
+
+        bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+        int length = (month == 2 && leap) ? 29 : monthDays[month - 1];
+        if (++day > length) {
+            day = 1;
+            if (++month > 12) {
+                month = 1;
+                year++;
+            }
+        }
+        weekday = (weekday + 1) % 7;
+        epochDay++;
+    }
+
+    // Ungültige Eingaben
+    static const char* const invalid[] = { "2023-02-29", "2024-04-31", "2024-13-01", "2024-00-10",
+                                           "2024-1-01", "24-01-01xx", "2024/01/01", "" };
+    for (const char* text : invalid) {
+        if (parseIsoDate(text, strlen(text)) != INVALID_EPOCH_DAY) {
+            Serial.printf("Selbsttest Datum: \"%s\" fälschlich akzeptiert\n", text);
+            errors++;
+        }
+    }
+
+    bool ok = errors == 0;
+    Serial.printf("Selbsttest Kalender: %ld Tage geprüft, %u Fehler -> %s\n",
+                  (long)epochDay, (unsigned)errors, ok ? "OK" : "FEHLER");
+    return ok;
+}
+
+#endif
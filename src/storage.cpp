@@ -4,7 +4,53 @@
 
 StorageManager storage;
 
-StorageManager::StorageManager() {
+// Hält den (rekursiven) Storage-Mutex für die Dauer eines Scopes. Vor begin()
+// existiert noch kein Mutex, dann ist die Sperre wirkungslos.
+class StorageLock {
+public:
+    explicit StorageLock(SemaphoreHandle_t mutex) : mutex(mutex) {
+        if (mutex) {
+            xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+        }
+    }
+    ~StorageLock() {
+        if (mutex) {
+            xSemaphoreGiveRecursive(mutex);
+        }
+    }
+
+private:
+    SemaphoreHandle_t mutex;
+};
+
+// Abgeleitete Datumsfelder: einmal beim Laden/Ändern berechnet statt bei jeder Anzeige
+static void prepareDates(Countdown& countdown) {
+    countdown.targetDay = parseIsoDate(countdown.targetDate);
+    countdown.recurrence = parseRecurrence(countdown.recurring, countdown.recurringInterval);
+    countdown.targetMinute = parseTimeOfDay(countdown.targetTime);
+}
+
+// Größe des Put-Records (siehe encodeCountdown()): Strings mit uint16
+// Längenpräfix plus Flags. Größere Countdowns passen nicht ins Journal und
+// werden gar nicht erst übernommen.
+static size_t encodedSize(const Countdown& countdown) {
+    return 6 * 2 + 1 + countdown.uid.length() + countdown.name.length() +
+           countdown.targetDate.length() + countdown.imagePath.length() +
+           countdown.recurringInterval.length() + countdown.targetTime.length();
+}
+
+static bool fitsJournal(const Countdown& countdown) {
+    if (encodedSize(countdown) > JOURNAL_MAX_PAYLOAD) {
+        Serial.print("Countdown zu groß für das Journal: ");
+        Serial.println(countdown.uid);
+        return false;
+    }
+    return true;
+}
+
+StorageManager::StorageManager()
+    : mutex(nullptr), flushTask(nullptr), wifiDirty(false),
+      firstDirtyTime(0), lastMutationTime(0), stats{}, generation(0), importState(ImportState::Idle) {
 }
 
 bool StorageManager::begin() {
@@ -15,19 +61,86 @@ bool StorageManager::begin() {
 
     Serial.println("LittleFS erfolgreich gemountet");
 
-    // Lade gespeicherte Konfiguration
-    loadFromFile();
+    if (!uidIndex.begin(MAX_COUNTDOWNS)) {
+        Serial.println("UID-Index konnte nicht angelegt werden!");
+        return false;
+    }
+
+    mutex = xSemaphoreCreateRecursiveMutex();
+    if (!mutex) {
+        Serial.println("Storage-Mutex konnte nicht angelegt werden!");
+        return false;
+    }
+
+    if (!loadStore()) {
+        return false;
+    }
+
+#if STORAGE_WRITE_BEHIND
+    // Ohne Task würde jede Änderung Flash im Web-Task schreiben: Startfehler
+    if (xTaskCreate(flushTaskEntry, "storage", STORAGE_TASK_STACK, this,
+                    STORAGE_TASK_PRIORITY, &flushTask) != pdPASS) {
+        Serial.println("Storage-Task konnte nicht gestartet werden!");
+        flushTask = nullptr;
+        return false;
+    }
+#endif
 
     return true;
 }
 
+bool StorageManager::loadStore() {
+    // Reste einer abgebrochenen Kompaktierung
+    if (LittleFS.exists(STORE_SNAPSHOT_FILE ".tmp")) {
+        LittleFS.remove(STORE_SNAPSHOT_FILE ".tmp");
+    }
+
+    if (!LittleFS.exists(STORE_SNAPSHOT_FILE) && !LittleFS.exists(STORE_JOURNAL_FILE)) {
+        if (LittleFS.exists(CONFIG_FILE)) {
+            // Einmalige Migration der alten JSON-Konfiguration
+            Serial.println("Migriere " CONFIG_FILE " in den Snapshot");
+            if (!importLegacyJson(CONFIG_FILE)) {
+                return false;
+            }
+            LittleFS.rename(CONFIG_FILE, CONFIG_FILE ".bak");
+            return true;
+        }
+
+        Serial.println("Kein Speicher vorhanden, erstelle neuen");
+        return compact();
+    }
+
+    // Snapshot laden, danach die Änderungen aus dem Journal nachspielen
+    bool clean = replayFile(STORE_SNAPSHOT_FILE);
+    clean = replayFile(STORE_JOURNAL_FILE) && clean;
+
+    Serial.print("Konfiguration geladen: ");
+    Serial.print(countdowns.size());
+    Serial.println(" Countdowns");
+
+    if (!clean) {
+        // Unvollständiger Record am Ende (z.B. Stromausfall) - alles davor ist
+        // übernommen, ein frischer Snapshot entfernt den defekten Rest
+        Serial.println("Journal beschädigt, kompaktiere");
+        return compact();
+    }
+
+    return openJournal();
+}
+
 bool StorageManager::addCountdown(const Countdown& countdown) {
+    StorageLock lock(mutex);
+
+    CardUid key;
+    if (!CardUid::fromHex(countdown.uid, key)) {
+        Serial.println("Ungültige UID!");
+        return false;
+    }
+
     // Prüfe ob UID bereits existiert
-    for (auto& cd : countdowns) {
-        if (cd.uid == countdown.uid) {
-            Serial.println("UID existiert bereits!");
-            return false;
-        }
+    if (uidIndex.find(key, countdowns) >= 0) {
+        Serial.println("UID existiert bereits!");
+        return false;
     }
 
     // Prüfe maximale Anzahl
@@ -36,59 +149,618 @@ bool StorageManager::addCountdown(const Countdown& countdown) {
         return false;
     }
 
-    countdowns.push_back(countdown);
-    return saveToFile();
+    if (!fitsJournal(countdown)) {
+        return false;
+    }
+
+    applyPut(countdown);
+    markDirty(countdown.uid);
+    return scheduleFlush();
 }
 
 bool StorageManager::updateCountdown(const String& uid, const Countdown& countdown) {
-    for (auto& cd : countdowns) {
-        if (cd.uid == uid) {
-            cd = countdown;
-            return saveToFile();
-        }
+    StorageLock lock(mutex);
+
+    int index = findIndex(uid);
+    if (index < 0) {
+        return false;
+    }
+
+    CardUid key;
+    if (!CardUid::fromHex(countdown.uid, key)) {
+        Serial.println("Ungültige UID!");
+        return false;
+    }
+
+    if (!fitsJournal(countdown)) {
+        return false;
+    }
+
+    // UID geändert (neue Karte zugewiesen) - darf keinen anderen Eintrag überschreiben
+    bool keyChanged = (key != countdowns[index].uidKey);
+    if (keyChanged && uidIndex.find(key, countdowns) >= 0) {
+        Serial.println("UID existiert bereits!");
+        return false;
+    }
+
+    if (keyChanged) {
+        // Alte UID wird beim Schreiben als gelöscht erkannt
+        markDirty(countdowns[index].uid);
     }
-    return false;
+    countdowns[index] = countdown;
+    countdowns[index].uidKey = key;
+    prepareDates(countdowns[index]);
+    if (keyChanged) {
+        uidIndex.rebuild(countdowns);
+    }
+    markDirty(countdown.uid);
+    return scheduleFlush();
 }
 
 bool StorageManager::deleteCountdown(const String& uid) {
-    for (size_t i = 0; i < countdowns.size(); i++) {
-        if (countdowns[i].uid == uid) {
-            countdowns.erase(countdowns.begin() + i);
-            return saveToFile();
+    StorageLock lock(mutex);
+
+    if (!applyDelete(uid)) {
+        return false;
+    }
+    markDirty(uid);
+    return scheduleFlush();
+}
+
+bool StorageManager::importCountdowns(std::vector<Countdown>&& list) {
+    StorageLock lock(mutex);
+
+    if (importState == ImportState::Pending) {
+        Serial.println("Import: vorheriger Import wird noch geschrieben!");
+        return false;
+    }
+
+    // Kapazität vorab prüfen, damit der Import nicht mittendrin abbricht
+    size_t added = 0;
+    for (size_t i = 0; i < list.size(); i++) {
+        if (!fitsJournal(list[i])) {
+            return false;
         }
+        if (findIndex(list[i].uid) >= 0) {
+            continue;
+        }
+        bool duplicate = false;
+        for (size_t j = 0; j < i && !duplicate; j++) {
+            duplicate = list[j].uid == list[i].uid;
+        }
+        if (!duplicate) {
+            added++;
+        }
+    }
+    if (countdowns.size() + added > MAX_COUNTDOWNS) {
+        Serial.println("Import: maximale Anzahl an Countdowns überschritten!");
+        return false;
+    }
+
+    importBatch = std::move(list);
+    importState = ImportState::Pending;
+    if (!flushTask) {
+        // STORAGE_WRITE_BEHIND false: synchron schreiben
+        commitImport();
+        return importState == ImportState::Committed;
+    }
+    xTaskNotifyGive(flushTask);
+    return true;
+}
+
+// Im Storage-Task: Snapshot aus aktuellem Zustand + Import schreiben (beim
+// Einlesen ersetzen die Import-Records die älteren gleicher UID). Erst wenn
+// er per rename() gilt, wird der Import in den RAM übernommen.
+void StorageManager::commitImport() {
+    StorageLock lock(mutex);
+    if (importState != ImportState::Pending) {
+        return;
+    }
+
+    unsigned long start = millis();
+    bool ok = writeSnapshot(&importBatch);
+    if (ok) {
+        for (const auto& countdown : importBatch) {
+            applyPut(countdown);
+        }
+        generation++;
+    }
+    Serial.printf("Import: %u Countdowns %s (%lu ms)\n", (unsigned)importBatch.size(),
+                  ok ? "übernommen" : "verworfen", millis() - start);
+
+    std::vector<Countdown>().swap(importBatch);
+    importState = ok ? ImportState::Committed : ImportState::Failed;
+
+    // Ein fehlendes Journal wird beim nächsten Schreiben erneut geöffnet
+    openJournal();
+}
+
+bool StorageManager::getCountdownByUID(const String& uid, Countdown& out) {
+    CardUid key;
+    if (!CardUid::fromHex(uid, key)) {
+        return false;
+    }
+    return getCountdownByUID(key, out);
+}
+
+bool StorageManager::getCountdownByUID(const CardUid& uid, Countdown& out) {
+    StorageLock lock(mutex);
+
+    int index = uidIndex.find(uid, countdowns);
+    if (index < 0 || !countdowns[index].active) {
+        return false;
     }
-    return false;
+    out = countdowns[index];
+    return true;
+}
+
+bool StorageManager::hasCountdown(const CardUid& uid) {
+    StorageLock lock(mutex);
+
+    int index = uidIndex.find(uid, countdowns);
+    return index >= 0 && countdowns[index].active;
 }
 
-Countdown* StorageManager::getCountdownByUID(const String& uid) {
-    for (auto& cd : countdowns) {
-        if (cd.uid == uid && cd.active) {
-            return &cd;
+int StorageManager::findIndex(const String& uid) {
+    CardUid key;
+    if (CardUid::fromHex(uid, key)) {
+        return uidIndex.find(key, countdowns);
+    }
+
+    // Alte Einträge mit nicht-hexadezimaler UID sind nicht im Index
+    for (size_t i = 0; i < countdowns.size(); i++) {
+        if (countdowns[i].uid == uid) {
+            return i;
         }
     }
-    return nullptr;
+    return -1;
 }
 
 std::vector<Countdown> StorageManager::getAllCountdowns() {
+    StorageLock lock(mutex);
     return countdowns;
 }
 
+size_t StorageManager::getCountdownCount() {
+    StorageLock lock(mutex);
+    return countdowns.size();
+}
+
+bool StorageManager::getCountdownAt(size_t index, Countdown& out) {
+    StorageLock lock(mutex);
+    if (index >= countdowns.size()) {
+        return false;
+    }
+    out = countdowns[index];
+    return true;
+}
+
 bool StorageManager::saveWiFiCredentials(const String& ssid, const String& password) {
+    StorageLock lock(mutex);
+
     wifiSSID = ssid;
     wifiPassword = password;
-    return saveToFile();
+    markWiFiDirty();
+    return scheduleFlush();
 }
 
 bool StorageManager::getWiFiCredentials(String& ssid, String& password) {
+    StorageLock lock(mutex);
+
     ssid = wifiSSID;
     password = wifiPassword;
     return (!wifiSSID.isEmpty());
 }
 
-bool StorageManager::saveToFile() {
+bool StorageManager::applyPut(const Countdown& countdown) {
+    int index = findIndex(countdown.uid);
+    if (index >= 0) {
+        countdowns[index] = countdown;
+        CardUid::fromHex(countdown.uid, countdowns[index].uidKey);
+        prepareDates(countdowns[index]);
+        return true;
+    }
+
+    if (countdowns.size() >= MAX_COUNTDOWNS) {
+        Serial.println("Maximale Anzahl an Countdowns erreicht!");
+        return false;
+    }
+
+    countdowns.push_back(countdown);
+    Countdown& added = countdowns.back();
+    prepareDates(added);
+    if (CardUid::fromHex(added.uid, added.uidKey)) {
+        uidIndex.insert(added.uidKey, countdowns.size() - 1);
+    } else {
+        added.uidKey = CardUid();
+    }
+    return true;
+}
+
+bool StorageManager::applyDelete(const String& uid) {
+    int index = findIndex(uid);
+    if (index < 0) {
+        return false;
+    }
+
+    // Nachfolgende Positionen verschieben sich, Index daher neu aufbauen
+    countdowns.erase(countdowns.begin() + index);
+    uidIndex.rebuild(countdowns);
+    return true;
+}
+
+bool StorageManager::openJournal() {
+    if (journal) {
+        journal.close();
+    }
+
+    bool fresh = !LittleFS.exists(STORE_JOURNAL_FILE);
+    journal = LittleFS.open(STORE_JOURNAL_FILE, "a");
+    if (!journal) {
+        Serial.println("Fehler beim Öffnen des Journals!");
+        return false;
+    }
+    if (fresh || journal.size() == 0) {
+        if (!writeJournalHeader(journal)) {
+            Serial.println("Fehler beim Schreiben des Journals!");
+            return false;
+        }
+        journal.flush();
+    }
+    return true;
+}
+
+bool StorageManager::replayFile(const char* path) {
+    if (!LittleFS.exists(path)) {
+        return true;
+    }
+
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+        Serial.print("Fehler beim Öffnen von ");
+        Serial.println(path);
+        return false;
+    }
+
+    JournalReader reader(file);
+    if (!reader.begin()) {
+        Serial.print("Ungültiger Header: ");
+        Serial.println(path);
+        file.close();
+        return false;
+    }
+
+    RecordType type;
+    std::vector<uint8_t> payload;
+    uint32_t records = 0;
+    JournalReader::Result result;
+    while ((result = reader.next(type, payload)) == JournalReader::Result::Record) {
+        RecordParser parser(payload.data(), payload.size());
+        applyRecord(type, parser);
+        records++;
+    }
+    file.close();
+
+    Serial.printf("%s: %u Records gelesen\n", path, (unsigned)records);
+
+    if (result == JournalReader::Result::Corrupt) {
+        Serial.printf("%s: ungültiger Record ab Byte %u verworfen\n", path, (unsigned)reader.getValidBytes());
+        return false;
+    }
+    return true;
+}
+
+void StorageManager::applyRecord(RecordType type, RecordParser& parser) {
+    switch (type) {
+        case RecordType::Put: {
+            Countdown cd;
+            uint8_t flags;
+            if (!parser.getString(cd.uid) || !parser.getString(cd.name) ||
+                !parser.getString(cd.targetDate) || !parser.getString(cd.imagePath) ||
+                !parser.getString(cd.recurringInterval) || !parser.getU8(flags)) {
+                Serial.println("Journal: ungültiger Countdown-Record");
+                return;
+            }
+            // Uhrzeit wurde später angehängt - ältere Records enden vorher
+            if (!parser.atEnd() && !parser.getString(cd.targetTime)) {
+                Serial.println("Journal: ungültiger Countdown-Record");
+                return;
+            }
+            cd.active = flags & 0x01;
+            cd.recurring = flags & 0x02;
+            applyPut(cd);
+            break;
+        }
+        case RecordType::Delete: {
+            String uid;
+            if (parser.getString(uid)) {
+                applyDelete(uid);
+            }
+            break;
+        }
+        case RecordType::WiFi:
+            parser.getString(wifiSSID);
+            parser.getString(wifiPassword);
+            break;
+        default:
+            // Unbekannter Typ (neuere Firmware) - überspringen
+            break;
+    }
+}
+
+void StorageManager::encodeCountdown(const Countdown& countdown) {
+    record.clear();
+    record.putString(countdown.uid);
+    record.putString(countdown.name);
+    record.putString(countdown.targetDate);
+    record.putString(countdown.imagePath);
+    record.putString(countdown.recurringInterval);
+    record.putU8((countdown.active ? 0x01 : 0) | (countdown.recurring ? 0x02 : 0));
+    record.putString(countdown.targetTime);
+}
+
+bool StorageManager::appendDelete(const String& uid) {
+    record.clear();
+    record.putString(uid);
+    return appendRecord(RecordType::Delete);
+}
+
+bool StorageManager::appendWiFi() {
+    record.clear();
+    record.putString(wifiSSID);
+    record.putString(wifiPassword);
+    return appendRecord(RecordType::WiFi);
+}
+
+bool StorageManager::appendRecord(RecordType type) {
+    if (!journal && !openJournal()) {
+        return false;
+    }
+
+    if (!appendJournalRecord(journal, type, record)) {
+        Serial.println("Fehler beim Schreiben des Journals!");
+        return false;
+    }
+    stats.recordsWritten++;
+    return true;
+}
+
+void StorageManager::markDirty(const String& uid) {
+    unsigned long now = millis();
+    if (pendingUids.empty() && !wifiDirty) {
+        firstDirtyTime = now;
+    }
+    lastMutationTime = now;
+    stats.mutations++;
+    generation++;
+
+    for (const auto& pending : pendingUids) {
+        if (pending == uid) {
+            stats.coalesced++;
+            return;
+        }
+    }
+    pendingUids.push_back(uid);
+}
+
+void StorageManager::markWiFiDirty() {
+    unsigned long now = millis();
+    if (pendingUids.empty() && !wifiDirty) {
+        firstDirtyTime = now;
+    }
+    lastMutationTime = now;
+    stats.mutations++;
+    generation++;
+
+    if (wifiDirty) {
+        stats.coalesced++;
+    }
+    wifiDirty = true;
+}
+
+bool StorageManager::scheduleFlush() {
+    if (!flushTask) {
+        // STORAGE_WRITE_BEHIND false: synchron im aufrufenden Task schreiben
+        return flush();
+    }
+    xTaskNotifyGive(flushTask);
+    return true;
+}
+
+bool StorageManager::flush() {
+    StorageLock lock(mutex);
+
+    if (pendingUids.empty() && !wifiDirty) {
+        return true;
+    }
+
+    unsigned long start = millis();
+    size_t written = 0;
+
+    // Pro UID genügt der aktuelle Zustand: vorhanden = PUT, sonst DEL.
+    // Nur fehlgeschlagene Records bleiben markiert, damit ein erneuter
+    // Versuch die bereits geschriebenen nicht noch einmal anhängt.
+    std::vector<String> failed;
+    for (const auto& uid : pendingUids) {
+        int index = findIndex(uid);
+        bool ok;
+        if (index >= 0) {
+            encodeCountdown(countdowns[index]);
+            if (record.size() > JOURNAL_MAX_PAYLOAD) {
+                // Kann nie geschrieben werden - verwerfen statt endlos zu wiederholen
+                Serial.print("Storage: Countdown zu groß, nicht gespeichert: ");
+                Serial.println(uid);
+                continue;
+            }
+            ok = appendRecord(RecordType::Put);
+        } else {
+            ok = appendDelete(uid);
+        }
+        if (ok) {
+            written++;
+        } else {
+            failed.push_back(uid);
+        }
+    }
+    if (wifiDirty && appendWiFi()) {
+        wifiDirty = false;
+        written++;
+    }
+    if (journal) {
+        journal.flush();
+    }
+
+    stats.flushes++;
+    Serial.printf("Storage: %u Änderungen geschrieben (%lu ms)\n", (unsigned)written, millis() - start);
+
+    pendingUids.swap(failed);
+    if (!pendingUids.empty() || wifiDirty) {
+        // Rest bleibt markiert und wird beim nächsten Flush erneut versucht
+        return false;
+    }
+
+    if (journal.size() >= JOURNAL_COMPACT_SIZE) {
+        return compact();
+    }
+    return true;
+}
+
+bool StorageManager::isDirty() {
+    StorageLock lock(mutex);
+    return !pendingUids.empty() || wifiDirty;
+}
+
+StorageStats StorageManager::getStats() {
+    StorageLock lock(mutex);
+    return stats;
+}
+
+void StorageManager::flushTaskEntry(void* param) {
+    static_cast<StorageManager*>(param)->flushLoop();
+}
+
+void StorageManager::flushLoop() {
+    for (;;) {
+        TickType_t wait = portMAX_DELAY;
+        bool due = false;
+        bool import = false;
+
+        {
+            StorageLock lock(mutex);
+            if (importState == ImportState::Pending) {
+                import = true;
+            } else if (!pendingUids.empty() || wifiDirty) {
+                // Schreiben nach einer Ruhephase, spätestens aber nach der Maximalverzögerung
+                unsigned long now = millis();
+                unsigned long quietDue = lastMutationTime + STORAGE_FLUSH_QUIET_MS;
+                unsigned long maxDue = firstDirtyTime + STORAGE_FLUSH_MAX_DELAY_MS;
+                unsigned long deadline = ((long)(quietDue - maxDue) < 0) ? quietDue : maxDue;
+                long remaining = (long)(deadline - now);
+                if (remaining <= 0) {
+                    due = true;
+                } else {
+                    wait = pdMS_TO_TICKS(remaining);
+                }
+            }
+        }
+
+        if (import) {
+            commitImport();
+            continue;
+        }
+        if (due) {
+            if (!flush()) {
+                // Fehler (z.B. Flash voll) - nicht in einer Schleife erneut versuchen
+                vTaskDelay(pdMS_TO_TICKS(STORAGE_FLUSH_MAX_DELAY_MS));
+            }
+            continue;
+        }
+
+        // Jede Änderung weckt den Task, damit die Fristen neu berechnet werden
+        ulTaskNotifyTake(pdTRUE, wait);
+    }
+}
+
+bool StorageManager::compact() {
+    StorageLock lock(mutex);
+    return writeSnapshot(nullptr) && openJournal();
+}
+
+// Schreibt den Zustand (plus ggf. noch nicht übernommene Einträge) als neuen
+// Snapshot und leert das Journal. Das Journal ist danach geschlossen.
+bool StorageManager::writeSnapshot(const std::vector<Countdown>* extra) {
+    unsigned long start = millis();
+
+    if (journal) {
+        journal.close();
+    }
+
+    const char* tempPath = STORE_SNAPSHOT_FILE ".tmp";
+    File file = LittleFS.open(tempPath, "w");
+    if (!file) {
+        Serial.println("Fehler beim Anlegen des Snapshots!");
+        return false;
+    }
+
+    bool ok = writeJournalHeader(file);
+
+    record.clear();
+    record.putString(wifiSSID);
+    record.putString(wifiPassword);
+    ok = ok && appendJournalRecord(file, RecordType::WiFi, record);
+
+    for (const auto& cd : countdowns) {
+        if (!ok) {
+            break;
+        }
+        encodeCountdown(cd);
+        if (record.size() > JOURNAL_MAX_PAYLOAD) {
+            // Ein einzelner zu großer Eintrag darf den Snapshot nicht verhindern
+            Serial.print("Snapshot: Countdown zu groß, übersprungen: ");
+            Serial.println(cd.uid);
+            continue;
+        }
+        ok = appendJournalRecord(file, RecordType::Put, record);
+    }
+    if (extra) {
+        // Größe wurde vor der Übernahme geprüft
+        for (size_t i = 0; ok && i < extra->size(); i++) {
+            encodeCountdown((*extra)[i]);
+            ok = appendJournalRecord(file, RecordType::Put, record);
+        }
+    }
+    file.close();
+
+    if (!ok) {
+        Serial.println("Fehler beim Schreiben des Snapshots!");
+        LittleFS.remove(tempPath);
+        return false;
+    }
+
+    // rename() ersetzt den alten Snapshot atomar. Stürzt das System vor dem
+    // Löschen des Journals ab, wird es beim nächsten Start erneut angewendet -
+    // das ist unkritisch, da jeder Record einen vollständigen Zustand enthält.
+    if (!LittleFS.rename(tempPath, STORE_SNAPSHOT_FILE)) {
+        Serial.println("Fehler beim Umbenennen des Snapshots!");
+        return false;
+    }
+    LittleFS.remove(STORE_JOURNAL_FILE);
+
+    // Der Snapshot enthält den kompletten Zustand inkl. ausstehender Änderungen
+    pendingUids.clear();
+    wifiDirty = false;
+    stats.compactions++;
+
+    Serial.printf("Snapshot geschrieben (%u Countdowns, %lu ms)\n",
+                  (unsigned)countdowns.size(), millis() - start);
+    return true;
+}
+
+bool StorageManager::exportLegacyJson(const char* path) {
+    StorageLock lock(mutex);
     String json = serializeToJson();
 
-    File file = LittleFS.open(CONFIG_FILE, "w");
+    File file = LittleFS.open(path, "w");
     if (!file) {
         Serial.println("Fehler beim Öffnen der Config-Datei zum Schreiben!");
         return false;
@@ -97,17 +769,13 @@ bool StorageManager::saveToFile() {
     file.print(json);
     file.close();
 
-    Serial.println("Konfiguration gespeichert");
+    Serial.println("Konfiguration exportiert");
     return true;
 }
 
-bool StorageManager::loadFromFile() {
-    if (!LittleFS.exists(CONFIG_FILE)) {
-        Serial.println("Config-Datei existiert nicht, erstelle neue");
-        return saveToFile();
-    }
-
-    File file = LittleFS.open(CONFIG_FILE, "r");
+bool StorageManager::importLegacyJson(const char* path) {
+    StorageLock lock(mutex);
+    File file = LittleFS.open(path, "r");
     if (!file) {
         Serial.println("Fehler beim Öffnen der Config-Datei!");
         return false;
@@ -116,13 +784,16 @@ bool StorageManager::loadFromFile() {
     String json = file.readString();
     file.close();
 
-    bool result = deserializeFromJson(json);
-    Serial.println("Konfiguration geladen");
-    return result;
+    if (!deserializeFromJson(json)) {
+        return false;
+    }
+
+    Serial.println("Konfiguration importiert");
+    return compact();
 }
 
 String StorageManager::serializeToJson() {
-    DynamicJsonDocument doc(4096);
+    DynamicJsonDocument doc(1024 + countdowns.size() * 512);
 
     // WiFi Einstellungen
     doc["wifi"]["ssid"] = wifiSSID;
@@ -135,6 +806,7 @@ String StorageManager::serializeToJson() {
         cdObj["uid"] = cd.uid;
         cdObj["name"] = cd.name;
         cdObj["targetDate"] = cd.targetDate;
+        cdObj["targetTime"] = cd.targetTime;
         cdObj["imagePath"] = cd.imagePath;
         cdObj["active"] = cd.active;
         cdObj["recurring"] = cd.recurring;
@@ -147,7 +819,7 @@ String StorageManager::serializeToJson() {
 }
 
 bool StorageManager::deserializeFromJson(const String& json) {
-    DynamicJsonDocument doc(4096);
+    DynamicJsonDocument doc(1024 + json.length() * 2);
     DeserializationError error = deserializeJson(doc, json);
 
     if (error) {
@@ -162,16 +834,34 @@ bool StorageManager::deserializeFromJson(const String& json) {
 
     // Countdowns
     countdowns.clear();
+    uidIndex.clear();
+    generation++;
     JsonArray cdArray = doc["countdowns"].as<JsonArray>();
     for (JsonObject cdObj : cdArray) {
+        if (countdowns.size() >= MAX_COUNTDOWNS) {
+            Serial.println("Maximale Anzahl an Countdowns erreicht, Rest ignoriert!");
+            break;
+        }
+
         Countdown cd;
         cd.uid = cdObj["uid"].as<String>();
         cd.name = cdObj["name"].as<String>();
         cd.targetDate = cdObj["targetDate"].as<String>();
+        cd.targetTime = cdObj["targetTime"] | "";  // Optional, Standard: leer
         cd.imagePath = cdObj["imagePath"] | "";  // Optional, Standard: leer
         cd.active = cdObj["active"].as<bool>();
         cd.recurring = cdObj["recurring"] | false;  // Optional, Standard: false
         cd.recurringInterval = cdObj["recurringInterval"] | "";  // Optional, Standard: leer
+        prepareDates(cd);
+
+        if (CardUid::fromHex(cd.uid, cd.uidKey)) {
+            if (uidIndex.find(cd.uidKey, countdowns) >= 0) {
+                Serial.print("Doppelte UID in Config ignoriert: ");
+                Serial.println(cd.uid);
+                continue;
+            }
+            uidIndex.insert(cd.uidKey, countdowns.size());
+        }
         countdowns.push_back(cd);
     }
 
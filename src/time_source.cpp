@@ -0,0 +1,315 @@
+#include "time_source.h"
+#include "config.h"
+#include "civil_date.h"
+#include "timer_service.h"
+#include <Preferences.h>
+#include <esp_sntp.h>
+#include <esp_timer.h>
+#include <sys/time.h>
+
+TimeSource timeSource;
+
+// Frühere Zeiten gelten als "nicht gestellt" (die Uhr startet bei 1970)
+static const time_t TIME_MIN_VALID = 1704067200;  // 2024-01-01
+
+// POSIX-TZ (z.B. "CET-1CEST,M3.5.0,M10.5.0/3"): Name aus mindestens drei
+// Buchstaben oder in spitzen Klammern ("<+03>")
+static const char* parseTzName(const char* p) {
+    const char* start;
+    if (*p == '<') {
+        start = ++p;
+        while (*p && *p != '>') {
+            p++;
+        }
+        return (*p == '>' && p - start >= 3) ? p + 1 : nullptr;
+    }
+    start = p;
+    while (isalpha((uint8_t)*p)) {
+        p++;
+    }
+    return p - start >= 3 ? p : nullptr;
+}
+
+// [+-]h[h[h]][:mm[:ss]]
+static const char* parseTzTime(const char* p) {
+    if (*p == '+' || *p == '-') {
+        p++;
+    }
+    if (!isdigit((uint8_t)*p)) {
+        return nullptr;
+    }
+    for (int digits = 0; digits < 3 && isdigit((uint8_t)*p); digits++) {
+        p++;
+    }
+    for (int i = 0; i < 2 && *p == ':'; i++) {
+        if (!isdigit((uint8_t)p[1]) || !isdigit((uint8_t)p[2])) {
+            return nullptr;
+        }
+        p += 3;
+    }
+    return p;
+}
+
+// Umstellungsregel: Mm.w.d, Jn oder n, optional /Zeit
+static const char* parseTzRule(const char* p) {
+    if (*p == 'M') {
+        p++;
+        for (int part = 0; part < 3; part++) {
+            if (!isdigit((uint8_t)*p)) {
+                return nullptr;
+            }
+            while (isdigit((uint8_t)*p)) {
+                p++;
+            }
+            if (part < 2 && *p++ != '.') {
+                return nullptr;
+            }
+        }
+    } else {
+        if (*p == 'J') {
+            p++;
+        }
+        if (!isdigit((uint8_t)*p)) {
+            return nullptr;
+        }
+        while (isdigit((uint8_t)*p)) {
+            p++;
+        }
+    }
+    return *p == '/' ? parseTzTime(p + 1) : p;
+}
+
+bool TimeSource::isValidTimeZone(const char* tz) {
+    if (!tz || strlen(tz) > TIME_ZONE_MAX_LENGTH) {
+        return false;
+    }
+
+    // Normalzeit mit Offset
+    const char* p = parseTzName(tz);
+    if (!p || !(p = parseTzTime(p))) {
+        return false;
+    }
+    if (*p == '\0') {
+        return true;
+    }
+
+    // Sommerzeit: Name, optional Offset, optional beide Umstellungsregeln
+    if (!(p = parseTzName(p))) {
+        return false;
+    }
+    if (*p != ',' && *p != '\0' && !(p = parseTzTime(p))) {
+        return false;
+    }
+    if (*p == '\0') {
+        return true;
+    }
+    if (*p++ != ',' || !(p = parseTzRule(p)) || *p++ != ',' || !(p = parseTzRule(p))) {
+        return false;
+    }
+    return *p == '\0';
+}
+
+const char* TimeSource::qualityName(TimeQuality quality) {
+    switch (quality) {
+        case TimeQuality::Restored: return "restored";
+        case TimeQuality::Retained: return "retained";
+        case TimeQuality::Synced:   return "synced";
+        default:                    return "invalid";
+    }
+}
+
+TimeSource::TimeSource()
+    : quality(TimeQuality::Invalid), syncStarted(false), retryDelay(TIME_SYNC_RETRY_MIN_S),
+      lastSyncTime(0), lastSaveTime(0), lastSyncUs(0), lastSyncMono(0), lastCorrectionMono(0),
+      syncCount(0), driftPpm(0), syncLock(portMUX_INITIALIZER_UNLOCKED), syncPending(false),
+      syncUs(0), syncMono(0), tzPending(false) {
+}
+
+void TimeSource::begin() {
+    applyTimeZone();
+
+    time_t saved = 0;
+    Preferences prefs;
+    if (prefs.begin(TIME_NVS_NAMESPACE, true)) {
+        saved = (time_t)prefs.getLong64("time", 0);
+        driftPpm = prefs.getFloat("drift", 0);
+        prefs.end();
+    }
+
+    time_t now = time(nullptr);
+    if (now >= TIME_MIN_VALID) {
+        // Der RTC-Timer läuft über Software-Neustarts weiter
+        quality = TimeQuality::Retained;
+        Serial.println("Zeit: Uhr lief über den Neustart weiter");
+    } else if (saved >= TIME_MIN_VALID) {
+        // Nach Stromausfall: letzte gesicherte Zeit (geht um die Ausfalldauer nach)
+        struct timeval tv = { saved, 0 };
+        settimeofday(&tv, nullptr);
+        quality = TimeQuality::Restored;
+        Serial.print("Zeit: letzte bekannte Zeit wiederhergestellt: ");
+        Serial.print(ctime(&saved));
+    } else {
+        Serial.println("Zeit: unbekannt bis zur ersten NTP-Synchronisation");
+    }
+
+    lastCorrectionMono = esp_timer_get_time();
+    sntp_set_time_sync_notification_cb(&TimeSource::onSync);
+
+    if (isValid()) {
+        lastSaveTime = time(nullptr);
+        timerService.timeChanged();
+        scheduleService(TIME_SAVE_INTERVAL_S);
+    }
+}
+
+void TimeSource::startSync() {
+    String tz = getTimeZone();
+    sntp_set_sync_interval(TIME_SYNC_INTERVAL_S * 1000UL);
+    configTzTime(tz.c_str(), NTP_SERVER_1, NTP_SERVER_2);
+
+    syncStarted = true;
+    retryDelay = TIME_SYNC_RETRY_MIN_S;
+    scheduleService(retryDelay);
+}
+
+// Im lwIP-Task: Zeitpunkt der Synchronisation festhalten, Auswertung in loop()
+void TimeSource::onSync(struct timeval* tv) {
+    portENTER_CRITICAL(&timeSource.syncLock);
+    timeSource.syncUs = (int64_t)tv->tv_sec * 1000000LL + tv->tv_usec;
+    timeSource.syncMono = esp_timer_get_time();
+    timeSource.syncPending = true;
+    portEXIT_CRITICAL(&timeSource.syncLock);
+
+    timerService.timeChanged();
+}
+
+void TimeSource::handleTimeChanged() {
+    if (tzPending) {
+        tzPending = false;
+        applyTimeZone();
+    }
+    if (!syncPending) {
+        return;
+    }
+
+    portENTER_CRITICAL(&syncLock);
+    int64_t ntpUs = syncUs;
+    int64_t mono = syncMono;
+    syncPending = false;
+    portEXIT_CRITICAL(&syncLock);
+
+    // Gang der Uhr: esp_timer (gleicher Quarz wie die Systemzeit) gegen NTP
+    // zwischen zwei Synchronisationen, geglättet
+    int64_t interval = ntpUs - lastSyncUs;
+    if (lastSyncMono != 0 && interval >= (int64_t)TIME_DRIFT_MIN_INTERVAL_S * 1000000LL) {
+        float measured = (float)((double)((mono - lastSyncMono) - interval) / (double)interval * 1e6);
+        driftPpm = (syncCount > 1) ? 0.7f * driftPpm + 0.3f * measured : measured;
+    }
+
+    if (quality != TimeQuality::Synced) {
+        time_t now = ntpUs / 1000000LL;
+        Serial.print("Zeit: per NTP synchronisiert: ");
+        Serial.print(ctime(&now));
+    }
+
+    quality = TimeQuality::Synced;
+    lastSyncUs = ntpUs;
+    lastSyncTime = ntpUs / 1000000LL;
+    lastSyncMono = mono;
+    lastCorrectionMono = mono;
+    syncCount++;
+    retryDelay = TIME_SYNC_RETRY_MIN_S;
+
+    saveState(lastSyncTime);
+    scheduleService(TIME_SAVE_INTERVAL_S);
+}
+
+void TimeSource::service() {
+    time_t now = time(nullptr);
+    bool stale = !isSynced() || now - lastSyncTime > 2 * TIME_SYNC_INTERVAL_S;
+
+    if (stale && isValid()) {
+        correctDrift();
+    }
+    if (isValid() && (now - lastSaveTime >= TIME_SAVE_INTERVAL_S || now < lastSaveTime)) {
+        saveState(now);
+    }
+
+    if (!stale || !syncStarted) {
+        scheduleService(TIME_SAVE_INTERVAL_S);
+        return;
+    }
+
+    // Keine (aktuelle) Synchronisation: SNTP neu anstoßen, Abstand verdoppeln
+    Serial.printf("Zeit: keine NTP-Synchronisation, neuer Versuch (nächster in %u s)\n",
+                  (unsigned)retryDelay);
+    sntp_restart();
+    scheduleService(retryDelay);
+    retryDelay = min((uint32_t)TIME_SYNC_RETRY_MAX_S, retryDelay * 2);
+}
+
+// Offline: bekannte Gangabweichung der Uhr sanft ausgleichen
+void TimeSource::correctDrift() {
+    int64_t mono = esp_timer_get_time();
+    int64_t elapsed = mono - lastCorrectionMono;
+    lastCorrectionMono = mono;
+    if (driftPpm == 0 || fabsf(driftPpm) > TIME_DRIFT_MAX_PPM) {
+        return;
+    }
+
+    int64_t correction = -(int64_t)((double)elapsed * driftPpm / 1e6);
+    struct timeval delta = { (time_t)(correction / 1000000LL), (suseconds_t)(correction % 1000000LL) };
+    adjtime(&delta, nullptr);
+}
+
+String TimeSource::getTimeZone() {
+    String tz;
+    Preferences prefs;
+    if (prefs.begin(TIME_NVS_NAMESPACE, true)) {
+        tz = prefs.getString("tz", "");
+        prefs.end();
+    }
+    return isValidTimeZone(tz.c_str()) ? tz : String(TIME_ZONE_DEFAULT);
+}
+
+bool TimeSource::setTimeZone(const String& tz) {
+    if (!isValidTimeZone(tz.c_str())) {
+        return false;
+    }
+
+    Preferences prefs;
+    if (!prefs.begin(TIME_NVS_NAMESPACE, false)) {
+        return false;
+    }
+    bool ok = prefs.putString("tz", tz) == tz.length();
+    prefs.end();
+
+    if (ok) {
+        tzPending = true;
+        timerService.timeChanged();
+    }
+    return ok;
+}
+
+void TimeSource::applyTimeZone() {
+    String tz = getTimeZone();
+    setenv("TZ", tz.c_str(), 1);
+    tzset();
+    invalidateLocalDay();
+    Serial.print("Zeitzone: ");
+    Serial.println(tz);
+}
+
+void TimeSource::saveState(time_t now) {
+    Preferences prefs;
+    if (prefs.begin(TIME_NVS_NAMESPACE, false)) {
+        prefs.putLong64("time", now);
+        prefs.putFloat("drift", driftPpm);
+        prefs.end();
+    }
+    lastSaveTime = now;
+}
+
+void TimeSource::scheduleService(uint32_t seconds) {
+    timerService.scheduleAt(TIMER_TIME_SOURCE, time(nullptr) + seconds);
+}
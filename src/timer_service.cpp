@@ -0,0 +1,106 @@
+#include "timer_service.h"
+#include <sys/time.h>
+
+TimerService timerService;
+
+TimerService::TimerService() : timer(nullptr), owner(nullptr), mutex(nullptr), deadlines{}, pending(0) {
+}
+
+bool TimerService::begin() {
+    owner = xTaskGetCurrentTaskHandle();
+    mutex = xSemaphoreCreateMutex();
+    if (!mutex) {
+        return false;
+    }
+
+    esp_timer_create_args_t args = {};
+    args.callback = &TimerService::onTimer;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "deadline";
+    if (esp_timer_create(&args, &timer) != ESP_OK) {
+        Serial.println("Timer konnte nicht angelegt werden!");
+        return false;
+    }
+    return true;
+}
+
+void TimerService::scheduleAt(TimerEvent event, time_t when) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    deadlines[event] = when;
+    arm();
+    xSemaphoreGive(mutex);
+}
+
+void TimerService::cancel(TimerEvent event) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    deadlines[event] = 0;
+    arm();
+    xSemaphoreGive(mutex);
+}
+
+void TimerService::timeChanged() {
+    pending |= TIMER_TIME_CHANGED;
+    wake();
+}
+
+void TimerService::configChanged() {
+    pending |= TIMER_CONFIG_CHANGED;
+    wake();
+}
+
+void TimerService::wake() {
+    if (owner) {
+        xTaskNotifyGive(owner);
+    }
+}
+
+uint32_t TimerService::waitForEvents(uint32_t timeoutMs) {
+    ulTaskNotifyTake(pdTRUE, timeoutMs == portMAX_DELAY ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs));
+    return pending.exchange(0);
+}
+
+// Timer auf den frühesten Termin stellen (Mutex gehalten)
+void TimerService::arm() {
+    esp_timer_stop(timer);
+
+    time_t earliest = 0;
+    for (uint8_t i = 0; i < TIMER_EVENT_COUNT; i++) {
+        if (deadlines[i] != 0 && (earliest == 0 || deadlines[i] < earliest)) {
+            earliest = deadlines[i];
+        }
+    }
+    if (earliest == 0) {
+        return;
+    }
+
+    struct timeval now;
+    gettimeofday(&now, nullptr);
+    int64_t delayUs = ((int64_t)earliest - now.tv_sec) * 1000000LL - now.tv_usec;
+    esp_timer_start_once(timer, delayUs > 1000 ? delayUs : 1000);
+}
+
+void TimerService::onTimer(void* arg) {
+    static_cast<TimerService*>(arg)->fire();
+}
+
+// Im esp_timer-Task: fällige Termine melden, Rest neu einplanen
+void TimerService::fire() {
+    time_t now = time(nullptr);
+    uint32_t due = 0;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    for (uint8_t i = 0; i < TIMER_EVENT_COUNT; i++) {
+        if (deadlines[i] != 0 && deadlines[i] <= now) {
+            deadlines[i] = 0;
+            due |= TIMER_DUE(i);
+        }
+    }
+    arm();
+    xSemaphoreGive(mutex);
+
+    if (due) {
+        pending |= due;
+        wake();
+    }
+}
@@ -0,0 +1,82 @@
+#include "uid_index.h"
+#include "storage.h"
+
+UidIndex::UidIndex() : slots(nullptr), mask(0) {
+}
+
+UidIndex::~UidIndex() {
+    free(slots);
+}
+
+bool UidIndex::begin(size_t capacity) {
+    // Ladefaktor <= 0.5 hält die Sondierketten kurz
+    size_t size = 8;
+    while (size < capacity * 2) {
+        size <<= 1;
+    }
+    if (size > 0x8000) {
+        return false;
+    }
+
+    free(slots);
+    slots = (Slot*)malloc(size * sizeof(Slot));
+    if (!slots) {
+        mask = 0;
+        return false;
+    }
+    mask = size - 1;
+    clear();
+    return true;
+}
+
+void UidIndex::clear() {
+    if (!slots) {
+        return;
+    }
+    for (uint32_t i = 0; i <= mask; i++) {
+        slots[i].position = EMPTY;
+        slots[i].tag = 0;
+    }
+}
+
+void UidIndex::insert(const CardUid& key, uint16_t position) {
+    if (!slots || key.isEmpty()) {
+        return;
+    }
+
+    uint32_t h = key.hash();
+    uint16_t tag = h >> 16;
+    for (uint32_t i = h & mask;; i = (i + 1) & mask) {
+        if (slots[i].position == EMPTY) {
+            slots[i].position = position;
+            slots[i].tag = tag;
+            return;
+        }
+    }
+}
+
+int UidIndex::find(const CardUid& key, const std::vector<Countdown>& countdowns) const {
+    if (!slots || key.isEmpty()) {
+        return -1;
+    }
+
+    uint32_t h = key.hash();
+    uint16_t tag = h >> 16;
+    for (uint32_t i = h & mask;; i = (i + 1) & mask) {
+        const Slot& slot = slots[i];
+        if (slot.position == EMPTY) {
+            return -1;
+        }
+        if (slot.tag == tag && slot.position < countdowns.size() &&
+            countdowns[slot.position].uidKey == key) {
+            return slot.position;
+        }
+    }
+}
+
+void UidIndex::rebuild(const std::vector<Countdown>& countdowns) {
+    clear();
+    for (size_t i = 0; i < countdowns.size(); i++) {
+        insert(countdowns[i].uidKey, i);
+    }
+}
@@ -1,115 +1,246 @@
 #include "webserver.h"
+#include "timer_service.h"
+#include "time_source.h"
 #include "storage.h"
 #include "rfid.h"
 #include "config.h"
+#include "image_transcoder.h"
+#include "json_stream.h"
+#include "ndjson.h"
+#include "router.h"
+#include "web_assets_data.h"
+#include <Preferences.h>
+#include <memory>
+
+// Zustand des laufenden Bild-Uploads (es wird immer nur ein Upload gleichzeitig
+// verarbeitet, weitere erhalten 503). uploadOwner ist der zugehörige Request.
+static ImageTranscoder imageUpload;
+static AsyncWebServerRequest* uploadOwner = nullptr;
+static struct {
+    bool success;
+    String path;
+    String error;
+} uploadResult;
+
+// Dateiname des Uploads ohne Pfad und Endung, nur [A-Za-z0-9_-] (andere
+// Zeichen werden zu '_'). Leer = unbrauchbarer Name.
+static String imageBaseName(const String& filename) {
+    int slash = max(filename.lastIndexOf('/'), filename.lastIndexOf('\\'));
+    String name = filename.substring(slash + 1);
+    int dot = name.lastIndexOf('.');
+    if (dot > 0) {
+        name = name.substring(0, dot);
+    }
+
+    String baseName;
+    for (size_t i = 0; i < name.length() && baseName.length() < IMAGE_NAME_MAX_LENGTH; i++) {
+        char c = name[i];
+        baseName += (isalnum((uint8_t)c) || c == '_' || c == '-') ? c : '_';
+    }
+    return baseName;
+}
+
+// ETags der REST API: "<bootId>-<Art><Generation>". Die Generationszähler
+// beginnen nach jedem Neustart bei 0, die zufällige bootId verhindert, dass
+// ein Browser dann einen alten Stand für aktuell hält.
+static uint32_t bootId = 0;
+// Generation des Bildverzeichnisses (Upload/Löschen)
+static volatile uint32_t imageGeneration = 0;
+
+static String makeETag(char kind, uint32_t generation) {
+    char tag[24];
+    snprintf(tag, sizeof(tag), "\"%08x-%c%u\"", (unsigned)bootId, kind, (unsigned)generation);
+    return String(tag);
+}
+
+// FNV-1a über eine fertige Antwort (für Daten ohne eigenen Generationszähler)
+static uint32_t contentHash(const String& content) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < content.length(); i++) {
+        h = (h ^ (uint8_t)content[i]) * 16777619u;
+    }
+    return h;
+}
+
+// Standard "no-cache": Browser muss jedes Mal nachfragen, bekommt aber 304 ohne Body
+static void addCacheHeaders(AsyncWebServerResponse* response, const String& etag,
+                            const char* cacheControl = "no-cache") {
+    response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", cacheControl);
+}
+
+// Beantwortet If-None-Match mit 304, wenn sich die Daten nicht geändert haben
+static bool sendNotModified(AsyncWebServerRequest* request, const String& etag,
+                            const char* cacheControl = "no-cache") {
+    const AsyncWebHeader* header = request->getHeader("If-None-Match");
+    if (!header || header->value().indexOf(etag) < 0) {
+        return false;
+    }
+
+    AsyncWebServerResponse* response = request->beginResponse(304);
+    addCacheHeaders(response, etag, cacheControl);
+    request->send(response);
+    return true;
+}
+
+// Sendet eine fertige JSON-Antwort mit ETag über den Inhalt
+static void sendJsonWithETag(AsyncWebServerRequest* request, char kind, const String& output) {
+    String etag = makeETag(kind, contentHash(output));
+    if (sendNotModified(request, etag)) {
+        return;
+    }
+
+    AsyncWebServerResponse* response = request->beginResponse(200, "application/json", output);
+    addCacheHeaders(response, etag);
+    request->send(response);
+}
 
-// Custom Handler für PUT /api/countdowns/:uid
-// Notwendig weil Regex-Patterns bei AsyncWebServer nicht funktionieren
-class CountdownPutHandler : public AsyncWebHandler {
+// Live-Werte (Zähler, Uhrzeit) ändern sich bei jeder Anfrage - ein ETag
+// würde nie passen und nur Hash-Aufwand kosten
+static void sendJsonUncached(AsyncWebServerRequest* request, const String& output) {
+    AsyncWebServerResponse* response = request->beginResponse(200, "application/json", output);
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+}
+
+// Streamt alle Countdowns direkt aus dem StorageManager (eine Kopie pro Element)
+class CountdownListStream : public JsonArrayStream {
 public:
-    bool canHandle(AsyncWebServerRequest *request) const override {
-        // Prüfe ob es ein PUT Request für /api/countdowns/:uid ist
-        if (request->method() == HTTP_PUT &&
-            request->url().startsWith("/api/countdowns/") &&
-            request->url().length() > 16) {
-            Serial.println("CountdownPutHandler: canHandle = true");
-            return true;
+    explicit CountdownListStream(JsonStreamFormat format = JsonStreamFormat::Array)
+        : JsonArrayStream(format) {}
+
+protected:
+    bool nextItem(JsonDocument& doc) override {
+        if (!storage.getCountdownAt(position++, current)) {
+            return false;
         }
-        return false;
+        JsonObject obj = doc.to<JsonObject>();
+        obj["uid"] = current.uid.c_str();
+        obj["name"] = current.name.c_str();
+        obj["targetDate"] = current.targetDate.c_str();
+        obj["targetTime"] = current.targetTime.c_str();
+        obj["imagePath"] = current.imagePath.c_str();
+        obj["active"] = current.active;
+        obj["recurring"] = current.recurring;
+        obj["recurringInterval"] = current.recurringInterval.c_str();
+        return true;
     }
 
-    void handleRequest(AsyncWebServerRequest *request) override {
-        // Wird nach handleBody() aufgerufen - aber wir haben schon in handleBody() geantwortet
-        // Daher tun wir hier nichts (request->send() wurde bereits aufgerufen)
-        Serial.println("CountdownPutHandler: handleRequest aufgerufen (Response bereits in handleBody gesendet)");
-    }
-
-    void handleBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) override {
-        // Body wird in Chunks gesendet - wir müssen auf den letzten Chunk warten
-        Serial.print("CountdownPutHandler: handleBody Chunk - index=");
-        Serial.print(index);
-        Serial.print(", len=");
-        Serial.print(len);
-        Serial.print(", total=");
-        Serial.println(total);
-
-        // Nur beim letzten Chunk verarbeiten
-        if (index + len != total) {
-            Serial.println("Warte auf weitere Chunks...");
-            return;
+private:
+    size_t position = 0;
+    Countdown current;
+};
+
+// Streamt den Inhalt von /images, das Verzeichnis bleibt dabei geöffnet
+class ImageListStream : public JsonArrayStream {
+public:
+    ImageListStream() {
+        root = LittleFS.open("/images");
+        if (root && !root.isDirectory()) {
+            root.close();
         }
+    }
 
-        Serial.println("Letzter Chunk empfangen, verarbeite Request");
-        Serial.print("URL: ");
-        Serial.println(request->url());
+protected:
+    bool nextItem(JsonDocument& doc) override {
+        if (!root) {
+            return false;
+        }
+        for (current = root.openNextFile(); current; current = root.openNextFile()) {
+            if (current.isDirectory()) {
+                continue;
+            }
+            name = current.name();
+            path = "/images/" + name;
+            JsonObject obj = doc.to<JsonObject>();
+            obj["name"] = name.c_str();
+            obj["path"] = path.c_str();
+            obj["size"] = current.size();
+            return true;
+        }
+        root.close();
+        return false;
+    }
 
-        String uid = request->url().substring(16); // Nach "/api/countdowns/"
-        Serial.print("Extrahierte UID: ");
-        Serial.println(uid);
+private:
+    File root;
+    File current;
+    String name;
+    String path;
+};
 
-        DynamicJsonDocument doc(1024);
-        DeserializationError error = deserializeJson(doc, data, len);
+// Sendet einen JsonArrayStream als Chunked Response
+static void sendJsonStream(AsyncWebServerRequest* request, std::shared_ptr<JsonArrayStream> stream,
+                           const String& etag, const char* contentType = "application/json") {
+    AsyncWebServerResponse* response = request->beginChunkedResponse(contentType,
+        [stream](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            return stream->fill(buffer, maxLen);
+        });
+    addCacheHeaders(response, etag);
+    request->send(response);
+}
 
-        if (error) {
-            Serial.print("JSON Parse Fehler: ");
-            Serial.println(error.c_str());
-            request->send(400, "application/json", "{\"success\":false,\"error\":\"Invalid JSON\"}");
+// Liefert das eingebettete Webinterface direkt aus dem Flash (gzip, mit ETag).
+// CSS/JS werden von index.html mit Inhalts-Hash referenziert und dürfen daher
+// unbegrenzt gecacht werden; index.html selbst wird per ETag revalidiert.
+class WebAssetHandler : public AsyncWebHandler {
+public:
+    bool canHandle(AsyncWebServerRequest *request) const override {
+        return request->method() == HTTP_GET && findWebAsset(request->url().c_str()) != nullptr;
+    }
+
+    void handleRequest(AsyncWebServerRequest *request) override {
+        const WebAsset* asset = findWebAsset(request->url().c_str());
+        if (!asset) {
+            request->send(404, "text/plain", "Not Found");
             return;
         }
 
-        Countdown cd;
-        cd.uid = doc["uid"].as<String>();
-        cd.name = doc["name"].as<String>();
-        cd.targetDate = doc["targetDate"].as<String>();
-        cd.imagePath = doc["imagePath"] | "";
-        cd.active = doc["active"].as<bool>();
-        cd.recurring = doc["recurring"] | false;
-        cd.recurringInterval = doc["recurringInterval"] | "";
-
-        Serial.print("Update Countdown: ");
-        Serial.print(cd.name);
-        Serial.print(", ImagePath: ");
-        Serial.print(cd.imagePath);
-        Serial.print(", Recurring: ");
-        Serial.println(cd.recurring ? cd.recurringInterval : "Nein");
-
-        bool result = storage.updateCountdown(uid, cd);
-        Serial.print("Update Result: ");
-        Serial.println(result ? "Erfolgreich" : "Fehlgeschlagen");
-
-        if (result) {
-            request->send(200, "application/json", "{\"success\":true}");
-        } else {
-            request->send(400, "application/json", "{\"success\":false,\"error\":\"Konnte Countdown nicht aktualisieren\"}");
+        const char* cacheControl = asset->immutable ? "public, max-age=31536000, immutable" : "no-cache";
+        if (sendNotModified(request, asset->etag, cacheControl)) {
+            return;
         }
+
+        AsyncWebServerResponse* response = request->beginResponse(200, asset->contentType, asset->data, asset->length);
+        response->addHeader("Content-Encoding", "gzip");
+        addCacheHeaders(response, asset->etag, cacheControl);
+        request->send(response);
     }
 };
 
 WebServerManager webServer;
 
-WebServerManager::WebServerManager() : server(80), apMode(true) {
+WebServerManager::WebServerManager()
+    : server(80), events("/api/events"), eventId(0), apMode(true),
+      netState(NetworkState::AccessPoint), connectStarted(0), fastConnect(false),
+      staGotIp(false), staDisconnected(false) {
 }
 
 bool WebServerManager::begin() {
-    // Versuche gespeicherte WiFi Credentials zu laden
-    String ssid, password;
-    if (storage.getWiFiCredentials(ssid, password) && !ssid.isEmpty()) {
-        if (connectToWiFi(ssid, password)) {
-            apMode = false;
-        } else {
-            Serial.println("Verbindung zu gespeichertem WiFi fehlgeschlagen, starte AP");
-            startAP();
+    bootId = esp_random();
+
+    // Zugangsdaten liegen im Storage, nicht zusätzlich im NVS des WiFi-Treibers
+    WiFi.persistent(false);
+    WiFi.onEvent([this](WiFiEvent_t event, WiFiEventInfo_t info) {
+        if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) {
+            staGotIp = true;
+        } else if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) {
+            staDisconnected = true;
         }
+        timerService.wake();  // handle() wertet die Flags in loop() aus
+    });
+
+    // Gespeicherte WiFi Credentials: Verbindung im Hintergrund aufbauen
+    if (storage.getWiFiCredentials(staSSID, staPassword) && !staSSID.isEmpty()) {
+        startConnect(true);
     } else {
         startAP();
     }
 
+    // Der Server nimmt Verbindungen an, sobald das Netzwerk steht
     setupRoutes();
     server.begin();
 
-    Serial.print("Webserver gestartet auf: ");
-    Serial.println(getIPAddress());
-
     return true;
 }
 
@@ -126,34 +257,78 @@ bool WebServerManager::startAP() {
         Serial.print("IP: ");
         Serial.println(WiFi.softAPIP());
         apMode = true;
+        netState = NetworkState::AccessPoint;
     }
 
     return success;
 }
 
-bool WebServerManager::connectToWiFi(const String& ssid, const String& password) {
+void WebServerManager::startConnect(bool useCache) {
+    uint8_t bssid[6];
+    int32_t channel = 0;
+    fastConnect = useCache && loadConnectCache(bssid, channel);
+
+    staGotIp = false;
+    staDisconnected = false;
     WiFi.mode(WIFI_STA);
-    WiFi.begin(ssid.c_str(), password.c_str());
+    if (fastConnect) {
+        // Bekannter AP: kein Scan über alle Kanäle nötig
+        WiFi.begin(staSSID.c_str(), staPassword.c_str(), channel, bssid);
+        Serial.printf("Verbinde zu WiFi: %s (Kanal %d, gecachte BSSID)\n", staSSID.c_str(), (int)channel);
+    } else {
+        WiFi.begin(staSSID.c_str(), staPassword.c_str());
+        Serial.printf("Verbinde zu WiFi: %s\n", staSSID.c_str());
+    }
+
+    apMode = false;
+    netState = NetworkState::Connecting;
+    connectStarted = millis();
+}
 
-    Serial.print("Verbinde zu WiFi: ");
-    Serial.println(ssid);
+void WebServerManager::onConnected() {
+    netState = NetworkState::Connected;
+    Serial.printf("WiFi verbunden nach %lu ms%s\n", millis() - connectStarted,
+                  fastConnect ? " (Schnellverbindung)" : "");
+    Serial.print("IP: ");
+    Serial.println(WiFi.localIP());
+    saveConnectCache();
+}
 
-    int attempts = 0;
-    while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-        delay(500);
-        Serial.print(".");
-        attempts++;
+// BSSID und Kanal des zuletzt verbundenen APs im NVS (Namespace "wifi").
+// Gilt nur für die SSID, mit der er gespeichert wurde.
+bool WebServerManager::loadConnectCache(uint8_t* bssid, int32_t& channel) {
+    Preferences prefs;
+    if (!prefs.begin(WIFI_CACHE_NAMESPACE, true)) {
+        return false;
     }
-    Serial.println();
+    bool valid = prefs.getString("ssid", "") == staSSID &&
+                 prefs.getBytes("bssid", bssid, 6) == 6;
+    channel = prefs.getUChar("channel", 0);
+    prefs.end();
+    return valid && channel > 0;
+}
 
-    if (WiFi.status() == WL_CONNECTED) {
-        Serial.println("WiFi verbunden!");
-        Serial.print("IP: ");
-        Serial.println(WiFi.localIP());
-        return true;
-    } else {
-        Serial.println("WiFi Verbindung fehlgeschlagen");
-        return false;
+void WebServerManager::saveConnectCache() {
+    const uint8_t* bssid = WiFi.BSSID();
+    int32_t channel = WiFi.channel();
+    if (!bssid || channel <= 0) {
+        return;
+    }
+
+    // Nur bei Änderung schreiben (schont den Flash)
+    uint8_t cached[6];
+    int32_t cachedChannel = 0;
+    if (loadConnectCache(cached, cachedChannel) && cachedChannel == channel &&
+        memcmp(cached, bssid, sizeof(cached)) == 0) {
+        return;
+    }
+
+    Preferences prefs;
+    if (prefs.begin(WIFI_CACHE_NAMESPACE, false)) {
+        prefs.putString("ssid", staSSID);
+        prefs.putBytes("bssid", bssid, 6);
+        prefs.putUChar("channel", (uint8_t)channel);
+        prefs.end();
     }
 }
 
@@ -166,115 +341,637 @@ String WebServerManager::getIPAddress() {
 }
 
 void WebServerManager::handle() {
-    // AsyncWebServer läuft asynchron, nichts zu tun
+    // AsyncWebServer läuft asynchron - hier nur der WiFi-Verbindungsaufbau
+    if (netState != NetworkState::Connecting) {
+        return;
+    }
+
+    if (staGotIp) {
+        onConnected();
+        return;
+    }
+
+    // Gecachter AP nicht (mehr) erreichbar: sofort mit vollem Scan neu versuchen
+    unsigned long elapsed = millis() - connectStarted;
+    if (fastConnect && (staDisconnected || elapsed >= WIFI_FAST_CONNECT_TIMEOUT_MS)) {
+        Serial.println("Schnellverbindung fehlgeschlagen, suche Netzwerk neu");
+        WiFi.disconnect();
+        startConnect(false);
+        return;
+    }
+
+    if (elapsed >= WIFI_CONNECT_TIMEOUT_MS) {
+        Serial.println("Verbindung zu gespeichertem WiFi fehlgeschlagen, starte AP");
+        WiFi.disconnect();
+        startAP();
+    }
 }
 
-void WebServerManager::setupRoutes() {
-    // API Endpoints zuerst definieren (vor serveStatic!)
+// ---------------------------------------------------------------------------
+// REST API Routen (statische Tabelle, siehe ROUTES unten)
+// ---------------------------------------------------------------------------
+
+static const char* JSON_INVALID = "{\"success\":false,\"error\":\"Invalid JSON\"}";
+
+// Router der REST API (in setupRoutes() angelegt)
+static Router* router = nullptr;
+
+// JSON-Bodies werden in der Arena des Requests geparst (zero-copy: das
+// Dokument verweist nur auf die Strings im Body, daher genügt ein kleines
+// StaticJsonDocument auf dem Stack)
+#define JSON_BODY_DOC_SIZE  256
+
+// Übernimmt die Felder eines Countdowns aus einem geparsten JSON-Objekt
+static void readCountdown(JsonDocument& doc, Countdown& cd) {
+    cd.uid = doc["uid"].as<String>();
+    cd.name = doc["name"].as<String>();
+    cd.targetDate = doc["targetDate"].as<String>();
+    cd.targetTime = doc["targetTime"] | "";
+    cd.imagePath = doc["imagePath"] | "";
+    cd.active = doc["active"].as<bool>();
+    cd.recurring = doc["recurring"] | false;
+    cd.recurringInterval = doc["recurringInterval"] | "";
+}
 
-    // GET /api/countdowns - Alle Countdowns abrufen
-    server.on("/api/countdowns", HTTP_GET, [this](AsyncWebServerRequest* request) {
-        handleGetCountdowns(request);
-    });
+// Liest einen Countdown aus dem JSON-Body (POST und PUT)
+static bool parseCountdown(RouteRequest& route, Countdown& cd) {
+    StaticJsonDocument<JSON_BODY_DOC_SIZE> doc;
+    DeserializationError error = deserializeJson(doc, (char*)route.body, route.bodyLength);
+    if (error) {
+        Serial.print("JSON Parse Fehler: ");
+        Serial.println(error.c_str());
+        return false;
+    }
 
-    // POST /api/countdowns - Neuen Countdown hinzufügen
-    server.on("/api/countdowns", HTTP_POST, [](AsyncWebServerRequest* request) {}, NULL,
-        [this](AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
-            DynamicJsonDocument doc(1024);
-            DeserializationError error = deserializeJson(doc, data, len);
+    readCountdown(doc, cd);
+    return true;
+}
 
-            if (error) {
-                request->send(400, "application/json", "{\"success\":false,\"error\":\"Invalid JSON\"}");
-                return;
-            }
+// Prüft einen Countdown (POST, PUT und Import), nullptr = gültig
+static const char* validateCountdown(const Countdown& cd) {
+    CardUid key;
+    if (!CardUid::fromHex(cd.uid, key)) {
+        return "Ungültige UID";
+    }
+    if (cd.name.isEmpty()) {
+        return "Name fehlt";
+    }
+    if (cd.name.length() > COUNTDOWN_NAME_MAX_LENGTH) {
+        return "Name zu lang";
+    }
+    if (cd.imagePath.length() > COUNTDOWN_PATH_MAX_LENGTH) {
+        return "Bildpfad zu lang";
+    }
+
+    // Datum im Format YYYY-MM-DD (inkl. Tage pro Monat und Schaltjahr)
+    bool dateOk = parseIsoDate(cd.targetDate) != INVALID_EPOCH_DAY;
+    if (!dateOk) {
+        return "Ungültiges Datum";
+    }
+
+    // Uhrzeit optional, sonst HH:MM. Daten nach 2038 sind erlaubt (Tageszahl
+    // über Epoch-Tage), der Stunden-Countdown entfällt dort bei 32-Bit time_t
+    // (siehe TIME_T_MAX_EPOCH_DAY)
+    if (!cd.targetTime.isEmpty() && parseTimeOfDay(cd.targetTime) == NO_TIME_OF_DAY) {
+        return "Ungültige Uhrzeit";
+    }
+
+    // Intervall auch ohne Wiederholung nur leer oder einer der bekannten Werte
+    bool intervalOk = cd.recurringInterval == "yearly" || cd.recurringInterval == "monthly" ||
+                      cd.recurringInterval == "weekly" ||
+                      (!cd.recurring && cd.recurringInterval.isEmpty());
+    if (!intervalOk) {
+        return "Ungültiges Intervall";
+    }
+    return nullptr;
+}
+
+static void sendValidationError(AsyncWebServerRequest* request, const char* error) {
+    request->send(400, "application/json",
+                  String("{\"success\":false,\"error\":\"") + error + "\"}");
+}
+
+// GET /api/countdowns - Alle Countdowns abrufen
+static void routeGetCountdowns(RouteRequest& route) {
+    String etag = makeETag('c', storage.getGeneration());
+    if (sendNotModified(route.request, etag)) {
+        return;
+    }
+    sendJsonStream(route.request, std::make_shared<CountdownListStream>(), etag);
+}
+
+// POST /api/countdowns - Neuen Countdown hinzufügen
+static void routeAddCountdown(RouteRequest& route) {
+    Countdown cd;
+    if (!parseCountdown(route, cd)) {
+        route.request->send(400, "application/json", JSON_INVALID);
+        return;
+    }
+
+    const char* error = validateCountdown(cd);
+    if (error) {
+        sendValidationError(route.request, error);
+        return;
+    }
+
+    if (storage.addCountdown(cd)) {
+        webServer.publishConfigChanged("countdowns");
+        route.request->send(200, "application/json", "{\"success\":true}");
+    } else {
+        route.request->send(400, "application/json", "{\"success\":false,\"error\":\"Konnte Countdown nicht hinzufügen\"}");
+    }
+}
+
+// PUT /api/countdowns/:uid - Countdown aktualisieren
+static void routeUpdateCountdown(RouteRequest& route) {
+    Countdown cd;
+    if (!parseCountdown(route, cd)) {
+        route.request->send(400, "application/json", JSON_INVALID);
+        return;
+    }
+
+    const char* error = validateCountdown(cd);
+    if (error) {
+        sendValidationError(route.request, error);
+        return;
+    }
+
+    String uid = route.paramString();
+    Serial.print("Update Countdown ");
+    Serial.print(uid);
+    Serial.print(": ");
+    Serial.println(cd.name);
+
+    if (storage.updateCountdown(uid, cd)) {
+        webServer.publishConfigChanged("countdowns");
+        route.request->send(200, "application/json", "{\"success\":true}");
+    } else {
+        route.request->send(400, "application/json", "{\"success\":false,\"error\":\"Konnte Countdown nicht aktualisieren\"}");
+    }
+}
+
+// DELETE /api/countdowns/:uid - Countdown löschen
+static void routeDeleteCountdown(RouteRequest& route) {
+    String uid = route.paramString();
+    Serial.print("Lösche Countdown: ");
+    Serial.println(uid);
+
+    if (storage.deleteCountdown(uid)) {
+        webServer.publishConfigChanged("countdowns");
+        route.request->send(200, "application/json", "{\"success\":true}");
+    } else {
+        route.request->send(400, "application/json", "{\"success\":false,\"error\":\"Konnte Countdown nicht löschen\"}");
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Bulk-Import und Export (NDJSON, ein Countdown pro Zeile)
+// ---------------------------------------------------------------------------
+
+// Ein laufender Bulk-Import: jede Zeile wird beim Empfang geparst und geprüft,
+// gepuffert werden nur die gültigen Countdowns und die ersten Fehler. Mehr als
+// BULK_IMPORT_MAX_LINES Zeilen verwerfen den ganzen Import (tooLarge).
+// Übernommen wird erst am Ende, in einer Transaktion.
+class BulkImport : public NdjsonLineReader {
+public:
+    struct LineError {
+        uint32_t line;
+        const char* error;
+    };
+
+    std::vector<Countdown> records;
+    std::vector<LineError> errors;      // Höchstens BULK_IMPORT_MAX_ERRORS
+    size_t lines = 0;
+    size_t failed = 0;
+    bool tooLarge = false;
+
+protected:
+    void onLine(uint32_t number, char* line, size_t len, bool overflow) override {
+        if (tooLarge) {
+            return;
+        }
+        if (number > BULK_IMPORT_MAX_LINES) {
+            tooLarge = true;
+            std::vector<Countdown>().swap(records);
+            std::vector<LineError>().swap(errors);
+            return;
+        }
+        lines++;
+
+        const char* error = nullptr;
+        Countdown cd;
 
-            Countdown cd;
-            cd.uid = doc["uid"].as<String>();
-            cd.name = doc["name"].as<String>();
-            cd.targetDate = doc["targetDate"].as<String>();
-            cd.imagePath = doc["imagePath"] | "";
-            cd.active = doc["active"].as<bool>();
-            cd.recurring = doc["recurring"] | false;
-            cd.recurringInterval = doc["recurringInterval"] | "";
-
-            if (storage.addCountdown(cd)) {
-                request->send(200, "application/json", "{\"success\":true}");
+        if (overflow) {
+            error = "Zeile zu lang";
+        } else if (records.size() >= MAX_COUNTDOWNS) {
+            error = "Zu viele Einträge";
+        } else {
+            StaticJsonDocument<JSON_BODY_DOC_SIZE> doc;
+            if (deserializeJson(doc, line, len) || !doc.is<JsonObject>()) {
+                error = "Ungültiges JSON";
             } else {
-                request->send(400, "application/json", "{\"success\":false,\"error\":\"Konnte Countdown nicht hinzufügen\"}");
+                readCountdown(doc, cd);
+                error = validateCountdown(cd);
             }
-        });
+        }
 
-    // PUT /api/countdowns/:uid - Countdown aktualisieren
-    // HINWEIS: Wird durch CountdownPutHandler behandelt (siehe oben)
-    // Muss als custom Handler registriert werden, da Regex-Patterns nicht funktionieren
-    server.addHandler(new CountdownPutHandler());
+        if (error) {
+            if (failed++ < BULK_IMPORT_MAX_ERRORS) {
+                errors.push_back({ number, error });
+            }
+        } else {
+            records.push_back(cd);
+        }
+    }
+};
 
-    // DELETE /api/countdowns/:uid - Countdown löschen
-    // HINWEIS: DELETE wird im onNotFound() Handler behandelt, da Regex-Patterns nicht funktionieren
-    // server.on() für DELETE ist daher auskommentiert
+// Antwort des Bulk-Imports: die fehlerhaften Zeilen, danach eine Zusammenfassung.
+// Einen angenommenen Import schreibt der Storage-Task; bis dahin ist ready()
+// false. Der Statuscode (200) ist dann schon gesendet, ob das Schreiben
+// gelungen ist, meldet "success" in der Zusammenfassung.
+class BulkResultStream : public JsonArrayStream {
+public:
+    BulkResultStream(std::shared_ptr<BulkImport> job, size_t count, bool accepted)
+        : JsonArrayStream(JsonStreamFormat::Lines), job(job), count(count),
+          waiting(accepted), committed(false) {}
+
+    bool ready() {
+        if (waiting) {
+            ImportState state = storage.getImportState();
+            if (state == ImportState::Pending) {
+                return false;
+            }
+            waiting = false;
+            committed = state == ImportState::Committed;
+            if (committed) {
+                webServer.publishConfigChanged("countdowns");
+            }
+        }
+        return true;
+    }
 
-    // GET /api/wifi - WiFi Einstellungen abrufen
-    server.on("/api/wifi", HTTP_GET, [this](AsyncWebServerRequest* request) {
-        handleGetWiFi(request);
-    });
+protected:
+    bool nextItem(JsonDocument& doc) override {
+        JsonObject obj = doc.to<JsonObject>();
+        if (position < job->errors.size()) {
+            const BulkImport::LineError& result = job->errors[position++];
+            obj["line"] = result.line;
+            obj["ok"] = false;
+            obj["error"] = result.error;
+            return true;
+        }
+        if (position++ == job->errors.size()) {
+            obj["success"] = committed;
+            obj["lines"] = job->lines;
+            obj["applied"] = committed ? count : 0;
+            obj["failed"] = job->failed;
+            return true;
+        }
+        return false;
+    }
 
-    // POST /api/wifi - WiFi Einstellungen setzen
-    server.on("/api/wifi", HTTP_POST, [](AsyncWebServerRequest* request) {}, NULL,
-        [this](AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
-            DynamicJsonDocument doc(512);
-            DeserializationError error = deserializeJson(doc, data, len);
+private:
+    std::shared_ptr<BulkImport> job;
+    size_t count;
+    bool waiting;
+    bool committed;
+    size_t position = 0;
+};
 
-            if (error) {
-                request->send(400, "application/json", "{\"success\":false,\"error\":\"Invalid JSON\"}");
-                return;
-            }
+// POST /api/countdowns/bulk - NDJSON wird Chunk für Chunk geparst, ohne den
+// Body zu puffern. Es läuft höchstens ein Import gleichzeitig (weitere: 503),
+// der Zustand bleibt bis zum Ende der Antwort bestehen.
+class BulkImportHandler : public AsyncWebHandler {
+public:
+    bool canHandle(AsyncWebServerRequest* request) const override {
+        return request->method() == HTTP_POST && request->url() == "/api/countdowns/bulk";
+    }
 
-            String ssid = doc["ssid"].as<String>();
-            String password = doc["password"].as<String>();
+    bool isRequestHandlerTrivial() const override { return false; }
 
-            if (storage.saveWiFiCredentials(ssid, password)) {
-                request->send(200, "application/json", "{\"success\":true,\"message\":\"WiFi Einstellungen gespeichert. Neustart erforderlich.\"}");
+    void handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) override {
+        if (index == 0 && !job) {
+            job = std::make_shared<BulkImport>();
+            owner = request;
+            request->onDisconnect([this, request]() {
+                if (owner == request) {
+                    job.reset();
+                    owner = nullptr;
+                }
+            });
+        }
+        if (owner == request) {
+            job->feed(data, len);
+        }
+    }
+
+    void handleRequest(AsyncWebServerRequest* request) override {
+        if (owner != request) {
+            if (job) {
+                request->send(503, "application/json", "{\"success\":false,\"error\":\"Import läuft bereits\"}");
             } else {
-                request->send(400, "application/json", "{\"success\":false,\"error\":\"Konnte WiFi Einstellungen nicht speichern\"}");
+                request->send(400, "application/json", "{\"success\":false,\"error\":\"Leerer Request\"}");
             }
-        });
+            return;
+        }
 
-    // GET /api/scan-card - Scanne RFID Karte
-    server.on("/api/scan-card", HTTP_GET, [this](AsyncWebServerRequest* request) {
-        handleScanCard(request);
-    });
+        job->finish();
+        if (job->tooLarge) {
+            request->send(413, "application/json", "{\"success\":false,\"error\":\"Zu viele Zeilen\"}");
+            return;
+        }
+
+        // Nur übernehmen, wenn alle Zeilen gültig sind
+        if (job->failed == 0 && storage.getImportState() == ImportState::Pending) {
+            request->send(503, "application/json", "{\"success\":false,\"error\":\"Import läuft bereits\"}");
+            return;
+        }
+        int code = 200;
+        size_t count = job->records.size();
+        bool accepted = false;
+        if (job->failed > 0 || count == 0) {
+            code = 422;
+        } else if (!storage.importCountdowns(std::move(job->records))) {
+            code = 507;
+        } else {
+            accepted = true;
+        }
+        Serial.printf("Bulk-Import: %u Zeilen, %u fehlerhaft, %s\n", (unsigned)job->lines,
+                      (unsigned)job->failed, accepted ? "an Storage übergeben" : "verworfen");
+
+        // Wartet (RESPONSE_TRY_AGAIN), bis der Storage-Task den Import geschrieben hat
+        auto stream = std::make_shared<BulkResultStream>(job, count, accepted);
+        AsyncWebServerResponse* response = request->beginChunkedResponse("application/x-ndjson",
+            [stream](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+                if (!stream->ready()) {
+                    return RESPONSE_TRY_AGAIN;
+                }
+                return stream->fill(buffer, maxLen);
+            });
+        response->setCode(code);
+        request->send(response);
+    }
 
-    // GET /api/status - System Status
-    server.on("/api/status", HTTP_GET, [this](AsyncWebServerRequest* request) {
-        DynamicJsonDocument doc(512);
-        doc["apMode"] = apMode;
-        doc["ip"] = getIPAddress();
-        doc["ssid"] = apMode ? WIFI_SSID : WiFi.SSID();
+private:
+    std::shared_ptr<BulkImport> job;
+    AsyncWebServerRequest* owner = nullptr;
+};
 
-        String output;
-        serializeJson(doc, output);
-        request->send(200, "application/json", output);
-    });
+// GET /api/export - Alle Countdowns als NDJSON (Format des Bulk-Imports)
+static void routeExport(RouteRequest& route) {
+    String etag = makeETag('e', storage.getGeneration());
+    if (sendNotModified(route.request, etag)) {
+        return;
+    }
+    sendJsonStream(route.request, std::make_shared<CountdownListStream>(JsonStreamFormat::Lines),
+                   etag, "application/x-ndjson");
+}
 
-    // Restart ESP
-    server.on("/api/restart", HTTP_POST, [](AsyncWebServerRequest* request) {
-        request->send(200, "application/json", "{\"success\":true,\"message\":\"Neustarte...\"}");
-        delay(500);
-        ESP.restart();
-    });
+// GET /api/wifi - WiFi Einstellungen abrufen
+static void routeGetWiFi(RouteRequest& route) {
+    String ssid, password;
+    storage.getWiFiCredentials(ssid, password);
+
+    DynamicJsonDocument doc(512);
+    doc["ssid"] = ssid;
+    doc["hasPassword"] = !password.isEmpty();
+    doc["apMode"] = webServer.isAPMode();
+
+    String output;
+    serializeJson(doc, output);
+    sendJsonWithETag(route.request, 'w', output);
+}
+
+// POST /api/wifi - WiFi Einstellungen setzen
+static void routeSetWiFi(RouteRequest& route) {
+    StaticJsonDocument<JSON_BODY_DOC_SIZE> doc;
+    DeserializationError error = deserializeJson(doc, (char*)route.body, route.bodyLength);
+    if (error) {
+        route.request->send(400, "application/json", JSON_INVALID);
+        return;
+    }
+
+    String ssid = doc["ssid"].as<String>();
+    String password = doc["password"].as<String>();
+
+    if (storage.saveWiFiCredentials(ssid, password)) {
+        webServer.publishConfigChanged("wifi");
+        route.request->send(200, "application/json", "{\"success\":true,\"message\":\"WiFi Einstellungen gespeichert. Neustart erforderlich.\"}");
+    } else {
+        route.request->send(400, "application/json", "{\"success\":false,\"error\":\"Konnte WiFi Einstellungen nicht speichern\"}");
+    }
+}
+
+// GET /api/time - Zeitzone und Zustand der Uhr
+static void routeGetTime(RouteRequest& route) {
+    time_t now = time(nullptr);
+
+    DynamicJsonDocument doc(512);
+    doc["tz"] = timeSource.getTimeZone();
+    doc["quality"] = TimeSource::qualityName(timeSource.getQuality());
+    if (timeSource.isValid()) {
+        struct tm local;
+        localtime_r(&now, &local);
+        char buffer[20];
+        strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M", &local);
+        doc["epoch"] = (uint32_t)now;
+        doc["local"] = buffer;
+    }
+    doc["lastSync"] = (uint32_t)timeSource.getLastSync();
+    doc["syncs"] = timeSource.getSyncCount();
+    doc["driftPpm"] = timeSource.getDriftPpm();
+
+    String output;
+    serializeJson(doc, output);
+    sendJsonUncached(route.request, output);
+}
+
+// POST /api/time - Zeitzone setzen (POSIX-TZ, z.B. "CET-1CEST,M3.5.0,M10.5.0/3")
+static void routeSetTime(RouteRequest& route) {
+    StaticJsonDocument<JSON_BODY_DOC_SIZE> doc;
+    DeserializationError error = deserializeJson(doc, (char*)route.body, route.bodyLength);
+    if (error) {
+        route.request->send(400, "application/json", JSON_INVALID);
+        return;
+    }
+
+    String tz = doc["tz"].as<String>();
+    tz.trim();
+    if (!TimeSource::isValidTimeZone(tz.c_str())) {
+        route.request->send(400, "application/json", "{\"success\":false,\"error\":\"Ungültige Zeitzone\"}");
+        return;
+    }
+
+    if (timeSource.setTimeZone(tz)) {
+        webServer.publishConfigChanged("time");
+        route.request->send(200, "application/json", "{\"success\":true}");
+    } else {
+        route.request->send(500, "application/json", "{\"success\":false,\"error\":\"Konnte Zeitzone nicht speichern\"}");
+    }
+}
+
+// GET /api/scan-card - Scanne RFID Karte
+static void routeScanCard(RouteRequest& route) {
+    webServer.handleScanCard(route.request);
+}
+
+// GET /api/status - System Status
+static void routeGetStatus(RouteRequest& route) {
+    DynamicJsonDocument doc(1024);
+    doc["apMode"] = webServer.isAPMode();
+    doc["ip"] = webServer.getIPAddress();
+    doc["ssid"] = webServer.isAPMode() ? WIFI_SSID : WiFi.SSID();
+
+    StorageStats stats = storage.getStats();
+    JsonObject storageObj = doc.createNestedObject("storage");
+    storageObj["dirty"] = storage.isDirty();
+    storageObj["mutations"] = stats.mutations;
+    storageObj["coalesced"] = stats.coalesced;
+    storageObj["flushes"] = stats.flushes;
+    storageObj["records"] = stats.recordsWritten;
+    storageObj["compactions"] = stats.compactions;
+
+    RfidStats rfid = rfidReader.getStats();
+    JsonObject rfidObj = doc.createNestedObject("rfid");
+    rfidObj["version"] = rfidReader.getVersion();
+    rfidObj["present"] = rfidReader.isCardPresent();
+    rfidObj["polls"] = rfid.polls;
+    rfidObj["reads"] = rfid.reads;
+    rfidObj["spiAvgUs"] = rfid.polls ? (uint32_t)(rfid.spiTimeUs / rfid.polls) : 0;
+    rfidObj["spiMaxUs"] = rfid.spiMaxUs;
+    rfidObj["contention"] = rfid.contention;
+    rfidObj["droppedEvents"] = rfidReader.getDroppedEvents();
+
+    JsonObject httpObj = doc.createNestedObject("http");
+    httpObj["bodyRejected"] = router->getRejectedCount();
+    httpObj["bodyBusy"] = router->getBusyCount();
+
+    String output;
+    serializeJson(doc, output);
+    sendJsonUncached(route.request, output);
+}
+
+// POST /api/restart - System neu starten
+static void routeRestart(RouteRequest& route) {
+    route.request->send(200, "application/json", "{\"success\":true,\"message\":\"Neustarte...\"}");
+    // Ausstehende Änderungen nicht verlieren
+    storage.flush();
+    delay(500);
+    ESP.restart();
+}
+
+// GET /api/images - Liste aller Bilder
+static void routeGetImages(RouteRequest& route) {
+    // Generation vor dem Lesen bestimmen: ändert sich das Verzeichnis währenddessen,
+    // liefert die nächste Anfrage den neuen Stand
+    String etag = makeETag('i', imageGeneration);
+    if (sendNotModified(route.request, etag)) {
+        return;
+    }
+    sendJsonStream(route.request, std::make_shared<ImageListStream>(), etag);
+}
+
+// DELETE /api/images/:filename - Bild löschen
+static void routeDeleteImage(RouteRequest& route) {
+    String fullPath = "/images/" + route.paramString();
+    Serial.print("Lösche Bild: ");
+    Serial.println(fullPath);
+
+    if (!LittleFS.exists(fullPath)) {
+        route.request->send(404, "application/json", "{\"success\":false,\"error\":\"Bild nicht gefunden\"}");
+        return;
+    }
+
+    if (LittleFS.remove(fullPath)) {
+        imageGeneration++;
+        webServer.publishConfigChanged("images");
+        route.request->send(200, "application/json", "{\"success\":true}");
+    } else {
+        Serial.println("Fehler beim Löschen: " + fullPath);
+        route.request->send(500, "application/json", "{\"success\":false,\"error\":\"Konnte Bild nicht löschen\"}");
+    }
+}
+
+// Maximale Body-Größe für JSON-Requests
+#define ROUTE_JSON_BODY     1024
+
+static const Route ROUTES[] = {
+    { HTTP_GET,    "/api/countdowns",      routeGetCountdowns,   0 },
+    { HTTP_POST,   "/api/countdowns",      routeAddCountdown,    ROUTE_JSON_BODY },
+    { HTTP_PUT,    "/api/countdowns/:uid", routeUpdateCountdown, ROUTE_JSON_BODY },
+    { HTTP_DELETE, "/api/countdowns/:uid", routeDeleteCountdown, 0 },
+    { HTTP_GET,    "/api/export",          routeExport,          0 },
+    { HTTP_GET,    "/api/wifi",            routeGetWiFi,         0 },
+    { HTTP_POST,   "/api/wifi",            routeSetWiFi,         512 },
+    { HTTP_GET,    "/api/time",            routeGetTime,         0 },
+    { HTTP_POST,   "/api/time",            routeSetTime,         512 },
+    { HTTP_GET,    "/api/scan-card",       routeScanCard,        0 },
+    { HTTP_GET,    "/api/status",          routeGetStatus,       0 },
+    { HTTP_POST,   "/api/restart",         routeRestart,         0 },
+    { HTTP_GET,    "/api/images",          routeGetImages,       0 },
+    { HTTP_DELETE, "/api/images/:filename", routeDeleteImage,    0 },
+};
+
+void WebServerManager::setupRoutes() {
+    // REST API über die Routen-Tabelle
+    router = new Router();
+    router->begin(ROUTES, sizeof(ROUTES) / sizeof(ROUTES[0]), BODY_ARENA_COUNT, BODY_ARENA_SIZE);
+    server.addHandler(router);
+    server.addHandler(new BulkImportHandler());
 
     // POST /api/upload-image - Bild hochladen
+    // Das Bild wird noch während des Empfangs Chunk für Chunk in das native
+    // Display-Format (.cdi, 1bpp, gedithert, auf IMAGE_MAX_WIDTH x IMAGE_MAX_HEIGHT skaliert) konvertiert
     server.on("/api/upload-image", HTTP_POST,
         [](AsyncWebServerRequest* request) {
             // Wird aufgerufen, wenn der Upload abgeschlossen ist
-            request->send(200, "application/json", "{\"success\":true,\"message\":\"Bild erfolgreich hochgeladen\"}");
+            if (uploadOwner != request) {
+                if (uploadOwner) {
+                    request->send(503, "application/json", "{\"success\":false,\"error\":\"Upload läuft bereits\"}");
+                } else {
+                    request->send(400, "application/json", "{\"success\":false,\"error\":\"Keine Datei empfangen\"}");
+                }
+                return;
+            }
+            uploadOwner = nullptr;
+
+            if (uploadResult.success) {
+                DynamicJsonDocument doc(256);
+                doc["success"] = true;
+                doc["message"] = "Bild erfolgreich hochgeladen";
+                doc["path"] = uploadResult.path;
+
+                String output;
+                serializeJson(doc, output);
+                request->send(200, "application/json", output);
+            } else {
+                DynamicJsonDocument doc(256);
+                doc["success"] = false;
+                doc["error"] = uploadResult.error.isEmpty() ? String("Upload fehlgeschlagen") : uploadResult.error;
+
+                String output;
+                serializeJson(doc, output);
+                request->send(400, "application/json", output);
+            }
         },
         [](AsyncWebServerRequest* request, const String& filename, size_t index, uint8_t* data, size_t len, bool final) {
             // Multipart File Upload Handler
-            static File uploadFile;
-
             if (index == 0) {
-                // Start des Uploads - erstelle Datei
+                if (uploadOwner && uploadOwner != request) {
+                    // Anderer Upload läuft noch - dieser wird mit 503 beantwortet
+                    return;
+                }
+                if (!uploadOwner) {
+                    uploadOwner = request;
+                    request->onDisconnect([request]() {
+                        if (uploadOwner == request) {
+                            imageUpload.abort();
+                            uploadOwner = nullptr;
+                        }
+                    });
+                }
+
+                // Start des Uploads - Konvertierung vorbereiten
                 Serial.println("Starte Bild-Upload: " + filename);
 
                 // Erstelle /images Verzeichnis falls nicht vorhanden
@@ -282,215 +979,177 @@ void WebServerManager::setupRoutes() {
                     LittleFS.mkdir("/images");
                 }
 
-                // Öffne Datei zum Schreiben
-                String path = "/images/" + filename;
-                uploadFile = LittleFS.open(path, "w");
-                if (!uploadFile) {
-                    Serial.println("Fehler beim Erstellen der Datei");
-                    request->send(500, "application/json", "{\"success\":false,\"error\":\"Konnte Datei nicht erstellen\"}");
+                // Zieldatei: bereinigter Name, Endung .cdi
+                String baseName = imageBaseName(filename);
+                uploadResult.success = false;
+                if (baseName.isEmpty()) {
+                    uploadResult.path = "";
+                    uploadResult.error = "Ungültiger Dateiname";
+                    imageUpload.abort();
                     return;
                 }
+                uploadResult.path = "/images/" + baseName + CDI_EXTENSION;
+                uploadResult.error = "";
+
+                imageUpload.begin(uploadResult.path, IMAGE_MAX_WIDTH, IMAGE_MAX_HEIGHT);
+            }
+            if (uploadOwner != request) {
+                return;
             }
 
-            // Schreibe Daten
-            if (uploadFile && len) {
-                uploadFile.write(data, len);
+            // Daten direkt konvertieren (Fehler werden beim Abschluss gemeldet)
+            if (imageUpload.isActive() && len) {
+                imageUpload.write(data, len);
             }
 
-            if (final) {
+            if (final && !uploadResult.path.isEmpty()) {
                 // Upload abgeschlossen
-                if (uploadFile) {
-                    uploadFile.close();
+                uploadResult.success = imageUpload.finish();
+                uploadResult.error = imageUpload.getError();
+                if (uploadResult.success) {
+                    imageGeneration++;
+                    webServer.publishConfigChanged("images");
+                    Serial.print("Bild-Upload abgeschlossen: ");
+                    Serial.print(uploadResult.path);
+                    Serial.print(" (");
+                    Serial.print(imageUpload.getOutputWidth());
+                    Serial.print("x");
+                    Serial.print(imageUpload.getOutputHeight());
+                    Serial.println(")");
                 }
-                Serial.println("Bild-Upload abgeschlossen: " + filename);
             }
         }
     );
 
-    // GET /api/images - Liste aller Bilder
-    server.on("/api/images", HTTP_GET, [](AsyncWebServerRequest* request) {
-        DynamicJsonDocument doc(2048);
-        JsonArray array = doc.to<JsonArray>();
-
-        File root = LittleFS.open("/images");
-        if (root && root.isDirectory()) {
-            File file = root.openNextFile();
-            while (file) {
-                if (!file.isDirectory()) {
-                    JsonObject obj = array.createNestedObject();
-                    obj["name"] = String(file.name());
-                    obj["path"] = "/images/" + String(file.name());
-                    obj["size"] = file.size();
-                }
-                file = root.openNextFile();
-            }
+    // GET /api/events - Server-Sent Events. Neue Clients erhalten sofort den
+    // aktuellen Zustand, danach nur noch Änderungen (kein Polling nötig).
+    events.onConnect([](AsyncEventSourceClient* client) {
+        DynamicJsonDocument doc(192);
+        doc["present"] = rfidReader.isCardPresent();
+        if (rfidReader.getLastReadTime() > 0) {
+            doc["uid"] = rfidReader.getLastCardUID();
         }
+        doc["generation"] = storage.getGeneration();
 
-        String output;
-        serializeJson(doc, output);
-        request->send(200, "application/json", output);
+        String data;
+        serializeJson(doc, data);
+        client->send(data.c_str(), "hello", millis());
     });
+    server.addHandler(&events);
 
-    // onNotFound Handler für API-Requests die nicht gematched wurden
-    // WORKAROUND: Regex-Patterns funktionieren nicht zuverlässig mit AsyncWebServer
-    // Deshalb fangen wir DELETE/PUT /api/countdowns/:uid hier ab
-    server.onNotFound([this](AsyncWebServerRequest* request) {
-        String url = request->url();
-
-        Serial.print("onNotFound: ");
-        Serial.print(request->methodToString());
-        Serial.print(" ");
-        Serial.println(url);
-
-        // Prüfe ob es ein API-Request für einen spezifischen Countdown ist
-        if (url.startsWith("/api/countdowns/") && url.length() > 16) {
-            String uid = url.substring(16); // Extrahiere UID nach "/api/countdowns/"
-
-            Serial.print("API Request erkannt, UID: ");
-            Serial.println(uid);
-
-            if (request->method() == HTTP_DELETE) {
-                Serial.println("DELETE Request wird verarbeitet");
-                handleDeleteCountdown(request);
-                return;
-            }
-            else if (request->method() == HTTP_PUT) {
-                Serial.println("WARNUNG: PUT Request im onNotFound Handler!");
-                Serial.println("Der CountdownPutHandler sollte diesen Request abfangen!");
-                // PUT sollte vom CountdownPutHandler behandelt werden
-                request->send(500, "application/json", "{\"success\":false,\"error\":\"PUT Handler nicht aktiv\"}");
-                return;
-            }
-        }
-
-        // Prüfe ob es ein DELETE Request für ein Bild ist: /api/images/:filename
-        if (url.startsWith("/api/images/") && url.length() > 12 && request->method() == HTTP_DELETE) {
-            String filename = url.substring(12); // Nach "/api/images/"
-            Serial.print("DELETE Image Request: ");
-            Serial.println(filename);
-
-            String fullPath = "/images/" + filename;
-            if (LittleFS.exists(fullPath)) {
-                if (LittleFS.remove(fullPath)) {
-                    Serial.println("Bild erfolgreich gelöscht: " + fullPath);
-                    request->send(200, "application/json", "{\"success\":true}");
-                } else {
-                    Serial.println("Fehler beim Löschen: " + fullPath);
-                    request->send(500, "application/json", "{\"success\":false,\"error\":\"Konnte Bild nicht löschen\"}");
-                }
-            } else {
-                Serial.println("Bild nicht gefunden: " + fullPath);
-                request->send(404, "application/json", "{\"success\":false,\"error\":\"Bild nicht gefunden\"}");
-            }
-            return;
-        }
+    // Webinterface aus dem Flash
+    server.addHandler(new WebAssetHandler());
 
-        // Für alle anderen 404s: Serve static files
-        // Versuche die Datei als statische Datei zu laden
-        if (LittleFS.exists(url)) {
-            request->send(LittleFS, url);
-        } else if (url.endsWith("/")) {
-            // Versuche index.html zu laden
-            String indexPath = url + "index.html";
-            if (LittleFS.exists(indexPath)) {
-                request->send(LittleFS, indexPath, "text/html");
-            } else {
-                request->send(404, "text/plain", "Not Found");
-            }
-        } else {
-            request->send(404, "text/plain", "Not Found");
-        }
+    server.onNotFound([](AsyncWebServerRequest* request) {
+        request->send(404, "text/plain", "Not Found");
     });
-
-    // Serve static files from LittleFS - MUSS am Ende stehen!
-    // Diese Zeile fängt ALLE nicht-gematchten Requests ab und serviert statische Dateien.
-    // Wenn sie am Anfang steht, werden die API-Routes nie erreicht!
-    server.serveStatic("/", LittleFS, "/").setDefaultFile("index.html");
 }
 
-void WebServerManager::handleGetCountdowns(AsyncWebServerRequest* request) {
-    DynamicJsonDocument doc(4096);
-    JsonArray array = doc.to<JsonArray>();
-
-    std::vector<Countdown> countdowns = storage.getAllCountdowns();
-    for (const auto& cd : countdowns) {
-        JsonObject obj = array.createNestedObject();
-        obj["uid"] = cd.uid;
-        obj["name"] = cd.name;
-        obj["targetDate"] = cd.targetDate;
-        obj["imagePath"] = cd.imagePath;
-        obj["active"] = cd.active;
-        obj["recurring"] = cd.recurring;
-        obj["recurringInterval"] = cd.recurringInterval;
+void WebServerManager::publish(const char* type, const String& data) {
+    if (events.count() == 0) {
+        return;
     }
-
-    String output;
-    serializeJson(doc, output);
-    request->send(200, "application/json", output);
+    events.send(data.c_str(), type, ++eventId);
 }
 
-void WebServerManager::handleDeleteCountdown(AsyncWebServerRequest* request) {
-    Serial.println("DELETE Request empfangen");
-    Serial.print("URL: ");
-    Serial.println(request->url());
-
-    String uid = request->url().substring(request->url().lastIndexOf('/') + 1);
-    Serial.print("Extrahierte UID: ");
-    Serial.println(uid);
-
-    if (uid.length() == 0) {
-        Serial.println("FEHLER: UID ist leer!");
-        request->send(400, "application/json", "{\"success\":false,\"error\":\"Keine UID angegeben\"}");
+void WebServerManager::publishCardEvent(const CardEvent& event) {
+    if (events.count() == 0) {
         return;
     }
-
-    bool result = storage.deleteCountdown(uid);
-    Serial.print("Delete Result: ");
-    Serial.println(result ? "Erfolgreich" : "Fehlgeschlagen");
-
-    if (result) {
-        request->send(200, "application/json", "{\"success\":true}");
+    char hex[CardUid::HEX_SIZE];
+    char data[64];
+    event.uid.toHex(hex);
+    if (event.type == CardEvent::Type::Arrived) {
+        snprintf(data, sizeof(data), "{\"uid\":\"%s\"}", hex);
+        events.send(data, "card-detected", ++eventId);
     } else {
-        request->send(400, "application/json", "{\"success\":false,\"error\":\"Konnte Countdown nicht löschen\"}");
+        snprintf(data, sizeof(data), "{\"uid\":\"%s\",\"dwellMs\":%u}", hex, (unsigned)event.dwellMs);
+        events.send(data, "card-removed", ++eventId);
     }
 }
 
-void WebServerManager::handleGetWiFi(AsyncWebServerRequest* request) {
-    String ssid, password;
-    storage.getWiFiCredentials(ssid, password);
+void WebServerManager::publishDisplayRefreshed(bool partial, uint32_t durationMs, uint32_t count) {
+    char data[80];
+    snprintf(data, sizeof(data), "{\"partial\":%s,\"durationMs\":%u,\"count\":%u}",
+             partial ? "true" : "false", (unsigned)durationMs, (unsigned)count);
+    publish("display-refreshed", data);
+}
 
-    DynamicJsonDocument doc(512);
-    doc["ssid"] = ssid;
-    doc["hasPassword"] = !password.isEmpty();
-    doc["apMode"] = apMode;
+void WebServerManager::publishConfigChanged(const char* what) {
+    char data[64];
+    snprintf(data, sizeof(data), "{\"what\":\"%s\",\"generation\":%u}",
+             what, (unsigned)storage.getGeneration());
+    publish("config-changed", data);
+    timerService.configChanged();
+}
+
+static String scanCardJson(const String& uid) {
+    if (uid.isEmpty()) {
+        return "{\"success\":false,\"error\":\"Keine Karte gefunden. Bitte Karte nah an Leser halten.\"}";
+    }
+    DynamicJsonDocument doc(256);
+    doc["success"] = true;
+    doc["uid"] = uid;
 
     String output;
     serializeJson(doc, output);
-    request->send(200, "application/json", output);
+    return output;
 }
 
 void WebServerManager::handleScanCard(AsyncWebServerRequest* request) {
-    // Versuche zuerst, eine Karte zu lesen
-    String uid = rfidReader.readCardUID();
-
-    // Wenn keine neue Karte, verwende die zuletzt gelesene (innerhalb von 10 Sekunden)
-    if (uid.length() == 0) {
-        unsigned long lastTime = rfidReader.getLastReadTime();
-        if (lastTime > 0 && (millis() - lastTime) < 10000) {  // 10 Sekunden Cache
-            uid = rfidReader.getLastCardUID();
-            Serial.println("Verwende gecachte Karten-UID für Web-Anfrage");
-        }
+    // Den Leser fragt nur der RFID-Task ab: aufliegende Karte oder die zuletzt
+    // gelesene (innerhalb von 10 Sekunden) verwenden
+    String uid;
+    unsigned long lastTime = rfidReader.getLastReadTime();
+    if (lastTime > 0 && (rfidReader.isCardPresent() || (millis() - lastTime) < 10000)) {
+        uid = rfidReader.getLastCardUID();
     }
 
-    if (uid.length() > 0) {
-        DynamicJsonDocument doc(256);
-        doc["success"] = true;
-        doc["uid"] = uid;
+    unsigned long waitMs = 0;
+    if (request->hasParam("wait")) {
+        waitMs = request->getParam("wait")->value().toInt();
+        waitMs = min(waitMs, (unsigned long)SCAN_CARD_MAX_WAIT_MS);
+    }
 
-        String output;
-        serializeJson(doc, output);
-        request->send(200, "application/json", output);
-    } else {
-        request->send(200, "application/json", "{\"success\":false,\"error\":\"Keine Karte gefunden. Bitte Karte nah an Leser halten.\"}");
+    if (uid.length() > 0 || waitMs == 0) {
+        request->send(200, "application/json", scanCardJson(uid));
+        return;
     }
+
+    // ?wait=<ms>: auf die nächste gelesene Karte warten. Die Antwort wird erst
+    // erzeugt, wenn der RFID-Task eine Karte meldet oder die Zeit abläuft -
+    // bis dahin liefert der Filler RESPONSE_TRY_AGAIN und der TCP-Task bleibt frei.
+    struct ScanWait {
+        uint32_t readCount;
+        unsigned long deadline;
+        String output;
+        size_t sent;
+        bool ready;
+    };
+    auto wait = std::make_shared<ScanWait>();
+    wait->readCount = rfidReader.getReadCount();
+    wait->deadline = millis() + waitMs;
+    wait->sent = 0;
+    wait->ready = false;
+
+    AsyncWebServerResponse* response = request->beginChunkedResponse("application/json",
+        [wait](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            if (!wait->ready) {
+                if (rfidReader.getReadCount() != wait->readCount) {
+                    wait->output = scanCardJson(rfidReader.getLastCardUID());
+                } else if ((long)(millis() - wait->deadline) < 0) {
+                    return RESPONSE_TRY_AGAIN;
+                } else {
+                    wait->output = scanCardJson(String());
+                }
+                wait->ready = true;
+            }
+
+            size_t n = min(maxLen, wait->output.length() - wait->sent);
+            memcpy(buffer, wait->output.c_str() + wait->sent, n);
+            wait->sent += n;
+            return n;
+        });
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
 }
@@ -3,15 +3,86 @@ const API_BASE = '/api';
 
 // State
 let countdowns = [];
+let events = null;
+let cardWaiters = [];
+let presentCard = null;     // UID der aufliegenden Karte (laut Event-Stream)
 
 // Initialize
 document.addEventListener('DOMContentLoaded', function() {
     loadStatus();
     loadCountdowns();
     loadWiFiSettings();
+    loadTimeSettings();
     loadImages();
+    connectEvents();
 });
 
+// Server-Sent Events: Karten und Änderungen werden vom Gerät gemeldet
+function connectEvents() {
+    if (!window.EventSource) {
+        return;
+    }
+
+    // Verbindungsabbrüche behandelt der Browser selbst (automatischer Reconnect)
+    events = new EventSource(`${API_BASE}/events`);
+
+    events.addEventListener('hello', (e) => {
+        const data = JSON.parse(e.data);
+        presentCard = data.present ? data.uid : null;
+    });
+
+    events.addEventListener('card-removed', () => {
+        presentCard = null;
+    });
+
+    events.addEventListener('card-detected', (e) => {
+        const data = JSON.parse(e.data);
+        presentCard = data.uid;
+        const waiters = cardWaiters;
+        cardWaiters = [];
+        waiters.forEach(resolve => resolve(data.uid));
+    });
+
+    events.addEventListener('config-changed', (e) => {
+        const data = JSON.parse(e.data);
+        if (data.what === 'countdowns') {
+            loadCountdowns();
+        } else if (data.what === 'images') {
+            loadImages();
+        } else if (data.what === 'wifi') {
+            loadWiFiSettings();
+        } else if (data.what === 'time') {
+            loadTimeSettings();
+        }
+    });
+}
+
+// Wartet auf die nächste Karte (null nach Ablauf von timeoutMs)
+function waitForCard(timeoutMs) {
+    // Ohne Event-Verbindung wartet der Server auf die Karte
+    if (!events || events.readyState !== EventSource.OPEN) {
+        return fetch(`${API_BASE}/scan-card?wait=${timeoutMs}`)
+            .then(response => response.json())
+            .then(data => data.success ? data.uid : null);
+    }
+
+    if (presentCard) {
+        return Promise.resolve(presentCard);
+    }
+
+    return new Promise(resolve => {
+        const timer = setTimeout(() => {
+            cardWaiters = cardWaiters.filter(waiter => waiter !== done);
+            resolve(null);
+        }, timeoutMs);
+        const done = (uid) => {
+            clearTimeout(timer);
+            resolve(uid);
+        };
+        cardWaiters.push(done);
+    });
+}
+
 // Load system status
 async function loadStatus() {
     try {
@@ -50,7 +121,8 @@ function renderCountdowns() {
     listElement.innerHTML = '';
 
     countdowns.forEach(countdown => {
-        const daysRemaining = calculateDaysRemaining(countdown.targetDate);
+        const nextDate = nextOccurrence(countdown);
+        const daysRemaining = calculateDaysRemaining(nextDate);
         const isActive = countdown.active ? '' : 'inactive';
         const hasImage = countdown.imagePath ? `🖼️ Bild: ${countdown.imagePath.split('/').pop()}` : '';
 
@@ -59,7 +131,7 @@ function renderCountdowns() {
         item.innerHTML = `
             <div class="countdown-info">
                 <h3>${countdown.name}</h3>
-                <p>📅 Datum: ${formatDate(countdown.targetDate)}</p>
+                <p>📅 Datum: ${formatDate(nextDate)}${countdown.targetTime ? `, ${countdown.targetTime} Uhr` : ''}${nextDate !== countdown.targetDate ? ` (seit ${formatDate(countdown.targetDate)})` : ''}</p>
                 <p>🔖 UID: ${countdown.uid}</p>
                 ${hasImage ? `<p>${hasImage}</p>` : ''}
                 ${countdown.active ? `<p class="days-remaining">⏱️ ${daysRemaining} Tage ${daysRemaining >= 0 ? 'verbleibend' : 'vergangen'}</p>` : '<p>⏸️ Inaktiv</p>'}
@@ -85,6 +157,42 @@ function calculateDaysRemaining(targetDate) {
     return diffDays;
 }
 
+// Next occurrence of a recurring countdown (same rules as the firmware):
+// the event day itself still counts, missing days are clamped to the month end
+function nextOccurrence(countdown) {
+    const anchor = new Date(countdown.targetDate + 'T00:00:00');
+    const today = new Date();
+    today.setHours(0, 0, 0, 0);
+
+    if (!countdown.recurring || isNaN(anchor) || anchor >= today) {
+        return countdown.targetDate;
+    }
+
+    const day = anchor.getDate();
+    const clamped = (year, month) => new Date(year, month, Math.min(day, new Date(year, month + 1, 0).getDate()));
+    let next;
+
+    if (countdown.recurringInterval === 'weekly') {
+        const weeks = Math.ceil(Math.round((today - anchor) / 86400000) / 7);
+        next = new Date(anchor.getFullYear(), anchor.getMonth(), day + weeks * 7);
+    } else if (countdown.recurringInterval === 'monthly') {
+        next = clamped(today.getFullYear(), today.getMonth());
+        if (next < today) {
+            next = clamped(today.getFullYear(), today.getMonth() + 1);
+        }
+    } else if (countdown.recurringInterval === 'yearly') {
+        next = clamped(today.getFullYear(), anchor.getMonth());
+        if (next < today) {
+            next = clamped(today.getFullYear() + 1, anchor.getMonth());
+        }
+    } else {
+        return countdown.targetDate;
+    }
+
+    const pad = n => String(n).padStart(2, '0');
+    return `${next.getFullYear()}-${pad(next.getMonth() + 1)}-${pad(next.getDate())}`;
+}
+
 // Format date to German format
 function formatDate(dateString) {
     const date = new Date(dateString + 'T00:00:00');
@@ -127,6 +235,7 @@ function editCountdown(uid) {
     document.getElementById('card-uid').value = countdown.uid;
     document.getElementById('countdown-name').value = countdown.name;
     document.getElementById('countdown-date').value = countdown.targetDate;
+    document.getElementById('countdown-time').value = countdown.targetTime || '';
     document.getElementById('countdown-image').value = countdown.imagePath || '';
     document.getElementById('countdown-active').checked = countdown.active;
     document.getElementById('countdown-recurring').checked = countdown.recurring || false;
@@ -144,18 +253,15 @@ function closeModal() {
 async function scanCard() {
     const button = event.target;
     button.disabled = true;
-    button.textContent = 'Scanne...';
+    button.textContent = 'Karte vorhalten...';
 
     try {
-        // Warte kurz, damit Benutzer Zeit hat die Karte zu positionieren
-        await new Promise(resolve => setTimeout(resolve, 500));
-
-        const response = await fetch(`${API_BASE}/scan-card`);
-        const data = await response.json();
+        // Die nächste Karte am Leser wird sofort gemeldet
+        const uid = await waitForCard(15000);
 
-        if (data.success) {
-            document.getElementById('card-uid').value = data.uid;
-            alert(`Karte gescannt: ${data.uid}`);
+        if (uid) {
+            document.getElementById('card-uid').value = uid;
+            alert(`Karte gescannt: ${uid}`);
         } else {
             alert('Keine Karte gefunden. Bitte Karte näher an den Leser halten und erneut versuchen.');
         }
@@ -179,6 +285,7 @@ async function saveCountdown(event) {
         uid: document.getElementById('card-uid').value.toUpperCase(),
         name: document.getElementById('countdown-name').value,
         targetDate: document.getElementById('countdown-date').value,
+        targetTime: document.getElementById('countdown-time').value,
         imagePath: document.getElementById('countdown-image').value,
         active: document.getElementById('countdown-active').checked,
         recurring: document.getElementById('countdown-recurring').checked,
@@ -290,6 +397,71 @@ async function saveWiFi(event) {
     }
 }
 
+const TIME_QUALITY_TEXT = {
+    invalid: 'unbekannt (noch keine Synchronisation)',
+    restored: 'wiederhergestellt nach Neustart (noch nicht synchronisiert)',
+    retained: 'über Neustart erhalten (noch nicht synchronisiert)',
+    synced: 'per NTP synchronisiert'
+};
+
+// Load time zone and clock state
+async function loadTimeSettings() {
+    try {
+        const response = await fetch(`${API_BASE}/time`);
+        const data = await response.json();
+
+        document.getElementById('time-zone').value = data.tz;
+        const preset = document.getElementById('time-zone-preset');
+        preset.value = data.tz;
+        if (preset.value !== data.tz) {
+            preset.value = '';
+        }
+
+        let status = 'Uhrzeit: ' + (data.local || '–') + ' – ' + (TIME_QUALITY_TEXT[data.quality] || data.quality);
+        if (data.syncs > 0) {
+            status += ` (${data.syncs} Synchronisationen, Gang ${data.driftPpm.toFixed(1)} ppm)`;
+        }
+        const element = document.getElementById('time-status');
+        element.textContent = status;
+        element.className = '';
+    } catch (error) {
+        console.error('Fehler beim Laden der Zeit:', error);
+    }
+}
+
+function selectTimeZonePreset() {
+    const preset = document.getElementById('time-zone-preset').value;
+    if (preset) {
+        document.getElementById('time-zone').value = preset;
+    }
+}
+
+// Save time zone (wirkt sofort, kein Neustart)
+async function saveTime(event) {
+    event.preventDefault();
+
+    const tz = document.getElementById('time-zone').value.trim();
+
+    try {
+        const response = await fetch(`${API_BASE}/time`, {
+            method: 'POST',
+            headers: { 'Content-Type': 'application/json' },
+            body: JSON.stringify({ tz })
+        });
+
+        const result = await response.json();
+
+        if (result.success) {
+            loadTimeSettings();
+        } else {
+            alert('Fehler: ' + (result.error || 'Unbekannter Fehler'));
+        }
+    } catch (error) {
+        console.error('Fehler beim Speichern:', error);
+        alert('Fehler beim Speichern der Zeitzone');
+    }
+}
+
 // Restart system
 async function restartSystem() {
     if (!confirm('System wirklich neu starten?')) {
@@ -421,9 +593,10 @@ async function uploadImage(event) {
         return;
     }
 
-    // Prüfe Dateityp
-    if (!file.name.toLowerCase().endsWith('.bmp')) {
-        alert('Nur BMP-Dateien werden unterstützt');
+    // Prüfe Dateityp (wird auf dem Gerät in das Display-Format konvertiert)
+    const name = file.name.toLowerCase();
+    if (!name.endsWith('.bmp') && !name.endsWith('.pgm')) {
+        alert('Nur BMP- und PGM-Dateien werden unterstützt');
         return;
     }
 